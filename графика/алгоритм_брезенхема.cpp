@@ -4,6 +4,10 @@
 #include <vector>
 #include <cmath>
 #include <algorithm>
+#include <cstdint>
+#include <thread>
+#include <cstring>
+#include "безоконный_режим.h"
 
 // Класс для работы с пикселями
 class PixelGrid {
@@ -51,6 +55,34 @@ public:
         }
     }
 
+    // Установить горизонтальный отрезок пикселей [x0, x1] в строке y одним квадом
+    void setSpan(int y, int x0, int x1, float r = 1.0f, float g = 1.0f, float b = 1.0f) {
+        float half = pixelSize / 2.0f;
+        float left = (2.0f * x0 / gridWidth) - 1.0f - half;
+        float right = (2.0f * x1 / gridWidth) - 1.0f + half;
+        float normY = 1.0f - (2.0f * y / gridHeight);
+
+        float square[] = {
+            left,  normY + half, r, g, b,
+            left,  normY - half, r, g, b,
+            right, normY + half, r, g, b,
+
+            left,  normY - half, r, g, b,
+            right, normY - half, r, g, b,
+            right, normY + half, r, g, b
+        };
+        vertices.insert(vertices.end(), square, square + 6 * 5);
+    }
+
+    // Зарезервировать место ещё под pixelCount пикселей. Сетка копится между кадрами,
+    // поэтому ёмкость растёт с удвоением и только при нехватке - иначе каждый кадр
+    // перевыделял бы массив точно по размеру и копирование стало бы квадратичным
+    void reserve(size_t pixelCount) {
+        size_t needed = vertices.size() + pixelCount * 6 * 5;
+        if (needed <= vertices.capacity()) return;
+        vertices.reserve(std::max(needed, vertices.capacity() * 2));
+    }
+
     // Получить массив вершин
     const std::vector<float>& getVertices() const {
         return vertices;
@@ -63,8 +95,9 @@ public:
 };
 
 // Алгоритм Брезенхема для прямой линии
+// skipStart - не ставить начальный пиксель (он уже нарисован предыдущим отрезком ломаной)
 void bresenhamLine(PixelGrid& grid, int x1, int y1, int x2, int y2,
-    float r = 1.0f, float g = 1.0f, float b = 1.0f) {
+    float r = 1.0f, float g = 1.0f, float b = 1.0f, bool skipStart = false) {
     /*
     Алгоритм Брезенхема:
     1. Вычисляем dx = |x2 - x1| и dy = |y2 - y1|
@@ -84,7 +117,8 @@ void bresenhamLine(PixelGrid& grid, int x1, int y1, int x2, int y2,
 
     while (true) {
         // Устанавливаем текущий пиксель
-        grid.setPixel(x1, y1, r, g, b);
+        if (!skipStart) grid.setPixel(x1, y1, r, g, b);
+        skipStart = false;
 
         // Если достигли конечной точки
         if (x1 == x2 && y1 == y2) break;
@@ -212,6 +246,719 @@ void bresenhamEllipse(PixelGrid& grid, int xc, int yc, int rx, int ry,
     }
 }
 
+// Точка кривой в координатах сетки (дробных)
+struct CurvePoint {
+    float x, y;
+};
+
+// Базовый класс кривой: хранит закэшированную ломаную
+class Curve {
+private:
+    std::vector<CurvePoint> polyline;
+    float cachedTolerance = -1.0f;
+
+protected:
+    // Построить ломаную с отклонением от кривой не больше tolerance (в пикселях)
+    virtual void flatten(float tolerance, std::vector<CurvePoint>& out) const = 0;
+
+    // Сбросить кэш (вызывается при изменении контрольных точек)
+    void invalidate() {
+        cachedTolerance = -1.0f;
+    }
+
+public:
+    virtual ~Curve() {}
+
+    // Получить ломаную; пересчитывается только при изменении кривой или точности
+    const std::vector<CurvePoint>& getPolyline(float tolerance = 0.25f) {
+        if (tolerance != cachedTolerance) {
+            polyline.clear();
+            flatten(tolerance, polyline);
+            cachedTolerance = tolerance;
+        }
+        return polyline;
+    }
+};
+
+// Квадратичная кривая Безье
+class QuadraticBezier : public Curve {
+private:
+    CurvePoint p0, p1, p2;
+
+    /*
+    Адаптивное разбиение (де Кастельжо):
+    максимальное отклонение квадратичной кривой от хорды равно |P0 - 2P1 + P2| / 4,
+    поэтому кривая считается плоской, если |P0 - 2P1 + P2|^2 <= 16 * tol^2.
+    Иначе делим пополам в t = 0.5 и обрабатываем половины.
+    */
+    static void subdivide(CurvePoint a, CurvePoint b, CurvePoint c,
+        float tol2, int depth, std::vector<CurvePoint>& out) {
+        float ddx = a.x - 2.0f * b.x + c.x;
+        float ddy = a.y - 2.0f * b.y + c.y;
+
+        if (depth >= 16 || ddx * ddx + ddy * ddy <= 16.0f * tol2) {
+            out.push_back(c);
+            return;
+        }
+
+        CurvePoint ab = { (a.x + b.x) * 0.5f, (a.y + b.y) * 0.5f };
+        CurvePoint bc = { (b.x + c.x) * 0.5f, (b.y + c.y) * 0.5f };
+        CurvePoint mid = { (ab.x + bc.x) * 0.5f, (ab.y + bc.y) * 0.5f };
+
+        subdivide(a, ab, mid, tol2, depth + 1, out);
+        subdivide(mid, bc, c, tol2, depth + 1, out);
+    }
+
+protected:
+    void flatten(float tolerance, std::vector<CurvePoint>& out) const override {
+        out.push_back(p0);
+        subdivide(p0, p1, p2, tolerance * tolerance, 0, out);
+    }
+
+public:
+    QuadraticBezier(CurvePoint start, CurvePoint control, CurvePoint end)
+        : p0(start), p1(control), p2(end) {
+    }
+
+    void setPoints(CurvePoint start, CurvePoint control, CurvePoint end) {
+        p0 = start;
+        p1 = control;
+        p2 = end;
+        invalidate();
+    }
+};
+
+// Кубическая кривая Безье
+class CubicBezier : public Curve {
+private:
+    CurvePoint p0, p1, p2, p3;
+
+    /*
+    Критерий плоскостности (Willcocks):
+    u = 3*P1 - 2*P0 - P3, v = 3*P2 - P0 - 2*P3,
+    отклонение от хорды не больше tol, если
+    max(ux^2, vx^2) + max(uy^2, vy^2) <= 16 * tol^2.
+    */
+    static void subdivide(CurvePoint a, CurvePoint b, CurvePoint c, CurvePoint d,
+        float tol2, int depth, std::vector<CurvePoint>& out) {
+        float ux = 3.0f * b.x - 2.0f * a.x - d.x;
+        float uy = 3.0f * b.y - 2.0f * a.y - d.y;
+        float vx = 3.0f * c.x - a.x - 2.0f * d.x;
+        float vy = 3.0f * c.y - a.y - 2.0f * d.y;
+
+        float flat = std::max(ux * ux, vx * vx) + std::max(uy * uy, vy * vy);
+        if (depth >= 16 || flat <= 16.0f * tol2) {
+            out.push_back(d);
+            return;
+        }
+
+        CurvePoint ab = { (a.x + b.x) * 0.5f, (a.y + b.y) * 0.5f };
+        CurvePoint bc = { (b.x + c.x) * 0.5f, (b.y + c.y) * 0.5f };
+        CurvePoint cd = { (c.x + d.x) * 0.5f, (c.y + d.y) * 0.5f };
+        CurvePoint abc = { (ab.x + bc.x) * 0.5f, (ab.y + bc.y) * 0.5f };
+        CurvePoint bcd = { (bc.x + cd.x) * 0.5f, (bc.y + cd.y) * 0.5f };
+        CurvePoint mid = { (abc.x + bcd.x) * 0.5f, (abc.y + bcd.y) * 0.5f };
+
+        subdivide(a, ab, abc, mid, tol2, depth + 1, out);
+        subdivide(mid, bcd, cd, d, tol2, depth + 1, out);
+    }
+
+protected:
+    void flatten(float tolerance, std::vector<CurvePoint>& out) const override {
+        out.push_back(p0);
+        subdivide(p0, p1, p2, p3, tolerance * tolerance, 0, out);
+    }
+
+public:
+    CubicBezier(CurvePoint start, CurvePoint control1, CurvePoint control2, CurvePoint end)
+        : p0(start), p1(control1), p2(control2), p3(end) {
+    }
+
+    void setPoints(CurvePoint start, CurvePoint control1, CurvePoint control2, CurvePoint end) {
+        p0 = start;
+        p1 = control1;
+        p2 = control2;
+        p3 = end;
+        invalidate();
+    }
+};
+
+// Дуга окружности (углы в радианах, обход от startAngle к endAngle)
+class Arc : public Curve {
+private:
+    CurvePoint center;
+    float radius;
+    float startAngle, endAngle;
+
+protected:
+    /*
+    Для дуги число отрезков считается сразу:
+    стрелка прогиба хорды с углом a равна R * (1 - cos(a / 2)),
+    значит шаг a = 2 * acos(1 - tol / R) даёт ошибку не больше tol.
+    Точки получаем поворотом вектора на шаг, без sin/cos на каждую точку.
+    */
+    void flatten(float tolerance, std::vector<CurvePoint>& out) const override {
+        float sweep = endAngle - startAngle;
+        float step = (tolerance < radius) ? 2.0f * acosf(1.0f - tolerance / radius)
+            : 3.14159265358979323846f;
+        int segments = std::max(2, (int)ceilf(fabsf(sweep) / step));
+
+        float delta = sweep / segments;
+        float cosD = cosf(delta);
+        float sinD = sinf(delta);
+        float dx = radius * cosf(startAngle);
+        float dy = radius * sinf(startAngle);
+
+        out.reserve(out.size() + segments + 1);
+        for (int i = 0; i <= segments; i++) {
+            out.push_back({ center.x + dx, center.y + dy });
+            float nx = dx * cosD - dy * sinD;
+            dy = dx * sinD + dy * cosD;
+            dx = nx;
+        }
+    }
+
+public:
+    Arc(CurvePoint c, float radius, float startAngle, float endAngle)
+        : center(c), radius(radius), startAngle(startAngle), endAngle(endAngle) {
+    }
+
+    void setAngles(float start, float end) {
+        startAngle = start;
+        endAngle = end;
+        invalidate();
+    }
+};
+
+// Растеризация ломаной через bresenhamLine
+// Общие вершины соседних отрезков рисуются один раз
+void bresenhamPolyline(PixelGrid& grid, const std::vector<CurvePoint>& points,
+    float r = 1.0f, float g = 1.0f, float b = 1.0f) {
+    if (points.empty()) return;
+
+    int prevX = (int)lroundf(points[0].x);
+    int prevY = (int)lroundf(points[0].y);
+    grid.setPixel(prevX, prevY, r, g, b);
+
+    for (size_t i = 1; i < points.size(); i++) {
+        int x = (int)lroundf(points[i].x);
+        int y = (int)lroundf(points[i].y);
+
+        // Вырожденный отрезок (обе точки в одном пикселе)
+        if (x == prevX && y == prevY) continue;
+
+        bresenhamLine(grid, prevX, prevY, x, y, r, g, b, true);
+        prevX = x;
+        prevY = y;
+    }
+}
+
+// Растеризация набора кривых одним пакетом:
+// сначала собираем ломаные (из кэша), резервируем память сетки, затем рисуем все отрезки
+void rasterizeCurves(PixelGrid& grid, const std::vector<Curve*>& curves,
+    float tolerance = 0.25f, float r = 1.0f, float g = 1.0f, float b = 1.0f) {
+    size_t estimate = 0;
+    for (Curve* curve : curves) {
+        const std::vector<CurvePoint>& points = curve->getPolyline(tolerance);
+        for (size_t i = 1; i < points.size(); i++) {
+            float dx = fabsf(points[i].x - points[i - 1].x);
+            float dy = fabsf(points[i].y - points[i - 1].y);
+            estimate += (size_t)std::max(dx, dy) + 1;
+        }
+    }
+    grid.reserve(estimate);
+
+    for (Curve* curve : curves) {
+        bresenhamPolyline(grid, curve->getPolyline(tolerance), r, g, b);
+    }
+}
+
+// ============================================
+// Толстые линии и окружности (вывод отрезками строк)
+// ============================================
+
+// Тип соединения сегментов толстой ломаной
+enum class LineJoin {
+    Bevel,  // срез
+    Miter,  // острый угол (с ограничением длины)
+    Round   // скругление
+};
+
+/*
+Буфер отрезков строк (span buffer):
+фигуры добавляют горизонтальные отрезки [x0, x1] в строки y,
+при выводе отрезки каждой строки сортируются и сливаются,
+поэтому каждый пиксель рисуется ровно один раз, даже если
+сегменты и соединения перекрываются.
+Центр пикселя (x, y) - целые координаты; пиксель закрашивается,
+если его центр лежит внутри фигуры.
+*/
+class SpanBuffer {
+private:
+    int minY;
+    std::vector<std::vector<std::pair<int, int>>> rows;
+
+public:
+    SpanBuffer(int minY, int maxY)
+        : minY(minY), rows(std::max(0, maxY - minY + 1)) {
+    }
+
+    void add(int y, int x0, int x1) {
+        if (x0 > x1 || y < minY || y >= minY + (int)rows.size()) return;
+        rows[y - minY].push_back({ x0, x1 });
+    }
+
+    // Выпуклый многоугольник: для каждой строки ищем крайние пересечения с рёбрами
+    void addConvexPolygon(const CurvePoint* pts, int n) {
+        float top = pts[0].y, bottom = pts[0].y;
+        for (int i = 1; i < n; i++) {
+            top = std::min(top, pts[i].y);
+            bottom = std::max(bottom, pts[i].y);
+        }
+
+        for (int y = (int)ceilf(top); y <= (int)floorf(bottom); y++) {
+            float xMin = 1e30f, xMax = -1e30f;
+            for (int i = 0; i < n; i++) {
+                const CurvePoint& a = pts[i];
+                const CurvePoint& b = pts[(i + 1) % n];
+                if ((y < a.y && y < b.y) || (y > a.y && y > b.y)) continue;
+
+                if (a.y == b.y) {
+                    xMin = std::min(xMin, std::min(a.x, b.x));
+                    xMax = std::max(xMax, std::max(a.x, b.x));
+                }
+                else {
+                    float x = a.x + (b.x - a.x) * (y - a.y) / (b.y - a.y);
+                    xMin = std::min(xMin, x);
+                    xMax = std::max(xMax, x);
+                }
+            }
+            add(y, (int)ceilf(xMin), (int)floorf(xMax));
+        }
+    }
+
+    // Круг радиуса radius
+    void addDisc(CurvePoint c, float radius) {
+        for (int y = (int)ceilf(c.y - radius); y <= (int)floorf(c.y + radius); y++) {
+            float dy = y - c.y;
+            float half = sqrtf(std::max(0.0f, radius * radius - dy * dy));
+            add(y, (int)ceilf(c.x - half), (int)floorf(c.x + half));
+        }
+    }
+
+    // Слить перекрывающиеся отрезки и вывести в сетку
+    void flush(PixelGrid& grid, float r, float g, float b) {
+        for (size_t i = 0; i < rows.size(); i++) {
+            std::vector<std::pair<int, int>>& row = rows[i];
+            if (row.empty()) continue;
+
+            std::sort(row.begin(), row.end());
+            int start = row[0].first, end = row[0].second;
+            for (size_t j = 1; j < row.size(); j++) {
+                if (row[j].first <= end + 1) {
+                    end = std::max(end, row[j].second);
+                }
+                else {
+                    grid.setSpan(minY + (int)i, start, end, r, g, b);
+                    start = row[j].first;
+                    end = row[j].second;
+                }
+            }
+            grid.setSpan(minY + (int)i, start, end, r, g, b);
+            row.clear();
+        }
+    }
+};
+
+// Прямоугольник сегмента толщины width (торцы без скругления)
+void addThickSegment(SpanBuffer& spans, CurvePoint a, CurvePoint b, float halfWidth) {
+    float dx = b.x - a.x, dy = b.y - a.y;
+    float len = sqrtf(dx * dx + dy * dy);
+    if (len == 0.0f) return;
+
+    float nx = -dy / len * halfWidth;
+    float ny = dx / len * halfWidth;
+    CurvePoint quad[4] = {
+        { a.x + nx, a.y + ny }, { b.x + nx, b.y + ny },
+        { b.x - nx, b.y - ny }, { a.x - nx, a.y - ny }
+    };
+    spans.addConvexPolygon(quad, 4);
+}
+
+// Толстая ломаная с соединениями сегментов
+void thickPolyline(PixelGrid& grid, const std::vector<CurvePoint>& points, float width,
+    LineJoin join = LineJoin::Miter, float r = 1.0f, float g = 1.0f, float b = 1.0f,
+    float miterLimit = 4.0f) {
+    if (points.size() < 2) return;
+
+    // Толщина меньше пикселя даёт разрывы строк
+    float halfWidth = std::max(width, 1.0f) * 0.5f;
+    float reach = halfWidth * std::max(miterLimit, 1.0f);
+
+    float top = points[0].y, bottom = points[0].y;
+    for (const CurvePoint& p : points) {
+        top = std::min(top, p.y);
+        bottom = std::max(bottom, p.y);
+    }
+    SpanBuffer spans((int)floorf(top - reach), (int)ceilf(bottom + reach));
+
+    for (size_t i = 1; i < points.size(); i++) {
+        addThickSegment(spans, points[i - 1], points[i], halfWidth);
+    }
+
+    // Соединения во внутренних вершинах
+    for (size_t i = 1; i + 1 < points.size(); i++) {
+        CurvePoint p = points[i];
+        if (join == LineJoin::Round) {
+            spans.addDisc(p, halfWidth);
+            continue;
+        }
+
+        float d0x = p.x - points[i - 1].x, d0y = p.y - points[i - 1].y;
+        float d1x = points[i + 1].x - p.x, d1y = points[i + 1].y - p.y;
+        float l0 = sqrtf(d0x * d0x + d0y * d0y);
+        float l1 = sqrtf(d1x * d1x + d1y * d1y);
+        if (l0 == 0.0f || l1 == 0.0f) continue;
+
+        // Нормали сегментов, развёрнутые к внешней стороне поворота
+        float side = (d0x * d1y - d0y * d1x > 0.0f) ? -1.0f : 1.0f;
+        float n0x = -d0y / l0 * side, n0y = d0x / l0 * side;
+        float n1x = -d1y / l1 * side, n1y = d1x / l1 * side;
+
+        CurvePoint outer0 = { p.x + n0x * halfWidth, p.y + n0y * halfWidth };
+        CurvePoint outer1 = { p.x + n1x * halfWidth, p.y + n1y * halfWidth };
+
+        // Длина острия: halfWidth / cos(угол / 2)
+        float cosHalf2 = (1.0f + n0x * n1x + n0y * n1y) * 0.5f;
+        if (join == LineJoin::Miter && cosHalf2 * miterLimit * miterLimit > 1.0f) {
+            float k = halfWidth / (2.0f * cosHalf2);
+            CurvePoint tip = { p.x + (n0x + n1x) * k, p.y + (n0y + n1y) * k };
+            CurvePoint miter[4] = { p, outer0, tip, outer1 };
+            spans.addConvexPolygon(miter, 4);
+        }
+        else {
+            CurvePoint bevel[3] = { p, outer0, outer1 };
+            spans.addConvexPolygon(bevel, 3);
+        }
+    }
+
+    spans.flush(grid, r, g, b);
+}
+
+// Толстая линия
+void thickLine(PixelGrid& grid, int x1, int y1, int x2, int y2, float width,
+    float r = 1.0f, float g = 1.0f, float b = 1.0f) {
+    std::vector<CurvePoint> points = { { (float)x1, (float)y1 }, { (float)x2, (float)y2 } };
+    thickPolyline(grid, points, width, LineJoin::Bevel, r, g, b);
+}
+
+// Толстая дуга: ломаная дуги (из кэша Arc) со скруглёнными соединениями
+void thickArc(PixelGrid& grid, Arc& arc, float width,
+    float r = 1.0f, float g = 1.0f, float b = 1.0f) {
+    thickPolyline(grid, arc.getPolyline(0.25f), width, LineJoin::Round, r, g, b);
+}
+
+/*
+Толстая окружность (кольцо):
+для каждой строки считаем полуширину внешнего и внутреннего кругов,
+строка даёт один или два отрезка - без наложений, буфер не нужен.
+*/
+void thickCircle(PixelGrid& grid, int xc, int yc, float radius, float width,
+    float r = 0.0f, float g = 1.0f, float b = 0.0f) {
+    float outer = radius + std::max(width, 1.0f) * 0.5f;
+    float inner = std::max(0.0f, radius - std::max(width, 1.0f) * 0.5f);
+
+    for (int dy = -(int)floorf(outer); dy <= (int)floorf(outer); dy++) {
+        float xo = sqrtf(std::max(0.0f, outer * outer - dy * dy));
+        int left0 = xc + (int)ceilf(-xo);
+        int right1 = xc + (int)floorf(xo);
+
+        if (fabsf((float)dy) < inner) {
+            float xi = sqrtf(inner * inner - dy * dy);
+            int left1 = xc + (int)floorf(-xi);
+            int right0 = xc + (int)ceilf(xi);
+            if (left1 + 1 < right0) {
+                grid.setSpan(yc + dy, left0, left1, r, g, b);
+                grid.setSpan(yc + dy, right0, right1, r, g, b);
+                continue;
+            }
+        }
+        grid.setSpan(yc + dy, left0, right1, r, g, b);
+    }
+}
+
+// ============================================
+// 3D обход вокселей (Amanatides–Woo)
+// ============================================
+
+// Воксельная сетка: плоский массив, индекс = (z * sizeY + y) * sizeX + x
+struct VoxelGrid {
+    int sizeX, sizeY, sizeZ;
+    std::vector<uint8_t> cells;  // 0 - пусто, иначе занято
+
+    VoxelGrid(int sx, int sy, int sz)
+        : sizeX(sx), sizeY(sy), sizeZ(sz), cells((size_t)sx * sy * sz, 0) {
+    }
+
+    size_t index(int x, int y, int z) const {
+        return ((size_t)z * sizeY + y) * sizeX + x;
+    }
+};
+
+// Луч/отрезок в координатах вокселей (воксель i занимает [i, i + 1))
+struct VoxelRay {
+    float x0, y0, z0;
+    float x1, y1, z1;
+};
+
+// Результат пакетного трассирования
+struct VoxelHit {
+    int x, y, z;   // первый занятый воксель
+    bool hit;
+};
+
+// Параметр t в фиксированной точке: отрезок соответствует [0, T_ONE]
+const int64_t T_ONE = (int64_t)1 << 30;
+const int64_t T_INF = INT64_MAX;
+// Смещение по оси меньше этого (в вокселях за весь отрезок) считается нулевым: границу
+// такая ось не пересекает (точность float-координат грубее), а T_ONE / dir не влезло бы в int64
+const float DIR_EPSILON = 1e-6f;
+
+// Состояние обхода по одной оси
+// Дойдя до last, ось замирает (tMax = T_INF): tMax в фиксированной точке округлён вниз,
+// и на отрезке, кончающемся на дальней грани сетки, ось иначе шагнула бы за последний
+// воксель раньше, чем остальные оси дойдут до своих
+struct VoxelAxis {
+    int cell, step, last;
+    int64_t tMax, tDelta;
+
+    void advance() {
+        cell += step;
+        tMax += tDelta;
+        if (cell == last) tMax = T_INF;
+    }
+
+    void init(float p0, float p1, float dir, int size) {
+        cell = std::min(std::max((int)floorf(p0), 0), size - 1);
+        last = std::min(std::max((int)floorf(p1), 0), size - 1);
+
+        if (dir > DIR_EPSILON) {
+            step = 1;
+            tDelta = (int64_t)(T_ONE / dir);
+            tMax = (int64_t)((cell + 1 - p0) * T_ONE / dir);
+        }
+        else if (dir < -DIR_EPSILON) {
+            step = -1;
+            tDelta = (int64_t)(T_ONE / -dir);
+            tMax = (int64_t)((p0 - cell) * T_ONE / -dir);
+        }
+        else {
+            step = 0;
+            tDelta = T_INF;
+            tMax = T_INF;
+        }
+        // Последний воксель по оси уже достигнут (или ось смотрит от него из-за округления)
+        if ((last - cell) * step <= 0) tMax = T_INF;
+    }
+};
+
+// Отсечение отрезка по границам сетки (метод слэбов)
+// Возвращает false, если отрезок не пересекает сетку
+bool clipToGrid(VoxelRay& ray, int sizeX, int sizeY, int sizeZ) {
+    float p0[3] = { ray.x0, ray.y0, ray.z0 };
+    float d[3] = { ray.x1 - ray.x0, ray.y1 - ray.y0, ray.z1 - ray.z0 };
+    float size[3] = { (float)sizeX, (float)sizeY, (float)sizeZ };
+    float tEnter = 0.0f, tExit = 1.0f;
+
+    for (int i = 0; i < 3; i++) {
+        if (d[i] == 0.0f) {
+            if (p0[i] < 0.0f || p0[i] >= size[i]) return false;
+            continue;
+        }
+        float t0 = (0.0f - p0[i]) / d[i];
+        float t1 = (size[i] - p0[i]) / d[i];
+        if (t0 > t1) std::swap(t0, t1);
+        tEnter = std::max(tEnter, t0);
+        tExit = std::min(tExit, t1);
+        if (tEnter > tExit) return false;
+    }
+
+    ray = { p0[0] + d[0] * tEnter, p0[1] + d[1] * tEnter, p0[2] + d[2] * tEnter,
+            p0[0] + d[0] * tExit,  p0[1] + d[1] * tExit,  p0[2] + d[2] * tExit };
+    return true;
+}
+
+/*
+Алгоритм Amanatides–Woo (3D аналог Брезенхема):
+1. Для каждой оси считаем tMax - параметр t, при котором луч пересечёт
+   ближайшую границу вокселя, и tDelta - длину вокселя в единицах t
+2. На каждом шаге переходим по оси с наименьшим tMax и прибавляем к нему tDelta
+3. t хранится в фиксированной точке (int64), поэтому цикл - только целочисленные
+   сравнения и сложения, без накопления ошибки float
+Посещаются ВСЕ воксели, через которые проходит отрезок (в отличие от выборки с шагом).
+visit(x, y, z) возвращает false, чтобы остановить обход.
+*/
+template <typename Visitor>
+void traverseVoxels(VoxelRay ray, int sizeX, int sizeY, int sizeZ, Visitor visit) {
+    if (!clipToGrid(ray, sizeX, sizeY, sizeZ)) return;
+
+    VoxelAxis ax, ay, az;
+    ax.init(ray.x0, ray.x1, ray.x1 - ray.x0, sizeX);
+    ay.init(ray.y0, ray.y1, ray.y1 - ray.y0, sizeY);
+    az.init(ray.z0, ray.z1, ray.z1 - ray.z0, sizeZ);
+
+    while (true) {
+        if (!visit(ax.cell, ay.cell, az.cell)) return;
+        if (ax.cell == ax.last && ay.cell == ay.last && az.cell == az.last) return;
+
+        // Шаг по оси с ближайшей границей
+        VoxelAxis* axis = &ax;
+        if (ay.tMax < axis->tMax) axis = &ay;
+        if (az.tMax < axis->tMax) axis = &az;
+
+        if (axis->tMax > T_ONE) return;
+        axis->advance();
+    }
+}
+
+// Трассировка одного луча до первого занятого вокселя
+// Индекс в плоском массиве обновляется приращением шага оси, без пересчёта (z * sy + y) * sx + x
+VoxelHit castVoxelRay(const VoxelGrid& grid, VoxelRay ray) {
+    VoxelHit result = { 0, 0, 0, false };
+    if (!clipToGrid(ray, grid.sizeX, grid.sizeY, grid.sizeZ)) return result;
+
+    VoxelAxis ax, ay, az;
+    ax.init(ray.x0, ray.x1, ray.x1 - ray.x0, grid.sizeX);
+    ay.init(ray.y0, ray.y1, ray.y1 - ray.y0, grid.sizeY);
+    az.init(ray.z0, ray.z1, ray.z1 - ray.z0, grid.sizeZ);
+
+    int64_t strideY = grid.sizeX;
+    int64_t strideZ = (int64_t)grid.sizeX * grid.sizeY;
+    int64_t offset[3] = { ax.step, ay.step * strideY, az.step * strideZ };
+    int64_t idx = (int64_t)grid.index(ax.cell, ay.cell, az.cell);
+    const uint8_t* cells = grid.cells.data();
+
+    while (true) {
+        if (cells[idx]) {
+            result = { ax.cell, ay.cell, az.cell, true };
+            return result;
+        }
+        if (ax.cell == ax.last && ay.cell == ay.last && az.cell == az.last) return result;
+
+        int a = 0;
+        int64_t tMin = ax.tMax;
+        if (ay.tMax < tMin) { a = 1; tMin = ay.tMax; }
+        if (az.tMax < tMin) { a = 2; tMin = az.tMax; }
+        if (tMin > T_ONE) return result;
+
+        VoxelAxis& axis = (a == 0) ? ax : (a == 1) ? ay : az;
+        axis.advance();
+        idx += offset[a];
+    }
+}
+
+// Пакетный режим: много лучей по одной сетке, лучи делятся между потоками
+void castVoxelRays(const VoxelGrid& grid, const std::vector<VoxelRay>& rays,
+    std::vector<VoxelHit>& hits, unsigned int threadCount = 0) {
+    hits.resize(rays.size());
+
+    if (threadCount == 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+    // Маленькие пакеты выгоднее считать в одном потоке
+    threadCount = (unsigned int)std::min<size_t>(threadCount, rays.size() / 1024 + 1);
+
+    auto work = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            hits[i] = castVoxelRay(grid, rays[i]);
+        }
+        };
+
+    if (threadCount == 1) {
+        work(0, rays.size());
+        return;
+    }
+
+    std::vector<std::thread> threads;
+    size_t chunk = (rays.size() + threadCount - 1) / threadCount;
+    for (unsigned int t = 0; t < threadCount; t++) {
+        size_t begin = t * chunk;
+        size_t end = std::min(rays.size(), begin + chunk);
+        if (begin >= end) break;
+        threads.emplace_back(work, begin, end);
+    }
+    for (std::thread& th : threads) th.join();
+}
+
+/*
+Самопроверка обхода вокселей (--test-voxels): отрезки, кончающиеся точно на дальних
+гранях, рёбрах и углах сетки, и случайные отрезки через сетку
+1. Каждый посещённый воксель лежит в сетке и отличается от предыдущего на 1 по одной оси
+2. castVoxelRay по сетке, где занят только последний посещённый воксель, попадает в него -
+   то есть идёт тем же путём, не выходя за массив
+Возвращает число отрезков с ошибкой.
+*/
+int testVoxelTraversal() {
+    const int SX = 100, SY = 100, SZ = 50;
+    VoxelGrid grid(SX, SY, SZ);
+
+    uint32_t seed = 12345;
+    auto random = [&seed](float scale) {
+        seed = seed * 1664525u + 1013904223u;
+        return (seed >> 8) / 16777216.0f * scale;
+    };
+
+    // Отрезки, на которых ось x или y раньше выходила за сетку
+    std::vector<VoxelRay> rays = {
+        { 10.0901947f, 85.8988495f, 26.3039436f, 100.0f, 100.0f, 41.0f },
+        { 61.1975327f, 89.053894f, 8.18502235f, 100.0f, 100.0f, -3.23838997f },
+        { -0.118860245f, 27.3701973f, 16.5128136f, 100.0f, 100.0f, 40.0f }
+    };
+    for (int i = 0; i < 20000; i++) {
+        VoxelRay ray = { random(SX), random(SY), random(SZ), random(SX), random(SY), random(SZ) };
+        switch (i % 8) {
+        case 0: ray.x1 = SX; break;
+        case 1: ray.y1 = SY; break;
+        case 2: ray.z1 = SZ; break;
+        case 3: ray.x1 = SX; ray.y1 = SY; break;
+        case 4: ray.y1 = SY; ray.z1 = SZ; break;
+        case 5: ray.x1 = SX; ray.y1 = SY; ray.z1 = SZ; break;
+        case 6: ray.x0 = random(3 * SX) - SX; ray.z0 = random(3 * SZ) - SZ; ray.x1 = SX; break;
+        default: break;
+        }
+        rays.push_back(ray);
+    }
+
+    int failures = 0;
+    for (const VoxelRay& ray : rays) {
+        bool ok = true;
+        int visited = 0;
+        int px = 0, py = 0, pz = 0;
+        traverseVoxels(ray, SX, SY, SZ, [&](int x, int y, int z) {
+            if (x < 0 || x >= SX || y < 0 || y >= SY || z < 0 || z >= SZ) ok = false;
+            if (visited > 0 && std::abs(x - px) + std::abs(y - py) + std::abs(z - pz) != 1) ok = false;
+            px = x; py = y; pz = z;
+            visited++;
+            return ok;
+        });
+
+        if (ok && visited > 0) {
+            size_t last = grid.index(px, py, pz);
+            grid.cells[last] = 1;
+            VoxelHit hit = castVoxelRay(grid, ray);
+            grid.cells[last] = 0;
+            ok = hit.hit && hit.x == px && hit.y == py && hit.z == pz;
+        }
+
+        if (!ok) {
+            failures++;
+            std::cerr << "Ошибка обхода: (" << ray.x0 << ", " << ray.y0 << ", " << ray.z0 << ") -> ("
+                << ray.x1 << ", " << ray.y1 << ", " << ray.z1 << ")" << std::endl;
+        }
+    }
+
+    std::cout << "Обход вокселей: отрезков " << rays.size() << ", с ошибкой " << failures << std::endl;
+    return failures;
+}
+
 // Шейдеры
 const char* vertexShaderSource = R"(
     #version 330 core
@@ -276,35 +1023,50 @@ unsigned int createShaderProgram() {
     return shaderProgram;
 }
 
-int main() {
-    // Инициализация GLFW
-    if (!glfwInit()) {
-        std::cerr << "Ошибка инициализации GLFW" << std::endl;
-        return -1;
+int main(int argc, char** argv) {
+    // --test-voxels: только самопроверка обхода вокселей, без окна и OpenGL
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--test-voxels") == 0) return testVoxelTraversal() == 0 ? 0 : 1;
     }
 
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    // --headless: без окна, рисование во внеэкранный буфер заданное число кадров
+    Headless::Options headless = Headless::parseArgs(argc, argv, 800, 800);
+    Headless::Context offscreen;
+    GLFWwindow* window = nullptr;
 
     // Размеры сетки пикселей
     const int GRID_WIDTH = 100;
     const int GRID_HEIGHT = 100;
 
-    // Создание окна
-    GLFWwindow* window = glfwCreateWindow(800, 800, "Алгоритм Брезенхема", NULL, NULL);
-    if (!window) {
-        std::cerr << "Ошибка создания окна" << std::endl;
-        glfwTerminate();
-        return -1;
+    if (headless.enabled) {
+        if (!offscreen.create(headless)) return -1;
     }
+    else {
+        // Инициализация GLFW
+        if (!glfwInit()) {
+            std::cerr << "Ошибка инициализации GLFW" << std::endl;
+            return -1;
+        }
 
-    glfwMakeContextCurrent(window);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
-    // Инициализация GLEW
-    if (glewInit() != GLEW_OK) {
-        std::cerr << "Ошибка инициализации GLEW" << std::endl;
-        return -1;
+        // Создание окна
+        window = glfwCreateWindow(800, 800, "Алгоритм Брезенхема", NULL, NULL);
+        if (!window) {
+            std::cerr << "Ошибка создания окна" << std::endl;
+            glfwTerminate();
+            return -1;
+        }
+
+        glfwMakeContextCurrent(window);
+
+        // Инициализация GLEW
+        if (glewInit() != GLEW_OK) {
+            std::cerr << "Ошибка инициализации GLEW" << std::endl;
+            return -1;
+        }
     }
 
     // Создание шейдерной программы
@@ -313,14 +1075,20 @@ int main() {
     // Создание сетки пикселей
     PixelGrid grid(GRID_WIDTH, GRID_HEIGHT, 0.018f);
 
+    // Кривые для демонстрации (ломаные строятся один раз и берутся из кэша)
+    QuadraticBezier quadCurve({ 10, 80 }, { 50, 5 }, { 90, 80 });
+    CubicBezier cubicCurve({ 10, 50 }, { 35, 0 }, { 65, 100 }, { 90, 50 });
+    Arc arc({ 50, 50 }, 40.0f, 0.0f, 3.14159265358979323846f);
+    std::vector<Curve*> curves = { &quadCurve, &cubicCurve, &arc };
+
     // Демонстрация разных алгоритмов
     int demoStep = 2;
 
     // Основной цикл
-    while (!glfwWindowShouldClose(window)) {
+    while (headless.enabled ? offscreen.nextFrame() : !glfwWindowShouldClose(window)) {
         // Обработка нажатий клавиш для смены демо
-        if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS) {
-            demoStep = (demoStep + 1) % 4;
+        if (!headless.enabled && glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS) {
+            demoStep = (demoStep + 1) % 7;
             grid.clear();
         }
 
@@ -346,6 +1114,26 @@ int main() {
         case 3: // Эллипс
             bresenhamEllipse(grid, 50, 50, 40, 20, 1.0f, 0.0f, 1.0f);
             break;
+
+        case 4: // Кривые Безье и дуга
+            rasterizeCurves(grid, curves, 0.25f, 1.0f, 1.0f, 0.0f);
+            break;
+
+        case 5: // 3D обход вокселей (проекция на плоскость XY, цвет - глубина z)
+            traverseVoxels({ 10.5f, 20.5f, 0.5f, 90.5f, 70.5f, 40.5f }, GRID_WIDTH, GRID_HEIGHT, 50,
+                [&](int x, int y, int z) {
+                    grid.setPixel(x, y, 0.0f, 1.0f - z / 50.0f, z / 50.0f);
+                    return true;
+                });
+            break;
+
+        case 6: // Толстые линии, ломаная с соединениями, кольцо и дуга
+            thickLine(grid, 10, 10, 90, 30, 5.0f, 1.0f, 0.5f, 0.0f);
+            thickPolyline(grid, { { 10, 90 }, { 30, 50 }, { 50, 85 }, { 70, 55 } }, 4.0f,
+                LineJoin::Miter, 0.0f, 1.0f, 1.0f);
+            thickCircle(grid, 70, 75, 15.0f, 4.0f, 0.0f, 1.0f, 0.0f);
+            thickArc(grid, arc, 3.0f, 1.0f, 0.0f, 1.0f);
+            break;
         }
 
         // Создание буферов OpenGL
@@ -375,12 +1163,16 @@ int main() {
         glDeleteBuffers(1, &VBO);
 
         // Обмен буферов и обработка событий
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        if (!headless.enabled) {
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+        }
     }
 
+    if (headless.enabled) offscreen.finish();
+
     glDeleteProgram(shaderProgram);
-    glfwTerminate();
+    if (!headless.enabled) glfwTerminate();
 
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,251 @@
+#pragma once
+#include <GL/glew.h>
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+
+// Без X11-типов в eglplatform.h (иначе макросы None, Bool, Status конфликтуют с кодом)
+#ifndef EGL_NO_X11
+#define EGL_NO_X11
+#endif
+#ifndef MESA_EGL_NO_X11_HEADERS
+#define MESA_EGL_NO_X11_HEADERS
+#endif
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+// ============================================
+// Безоконный режим (EGL без поверхности + FBO)
+// ============================================
+
+// Запуск демо с ключом --headless: окно GLFW не создаётся, контекст OpenGL
+// поднимается через EGL (платформа surfaceless Mesa, работает на llvmpipe без
+// дисплея и GPU), кадры рисуются во внеэкранный FBO заданное число раз.
+//   --headless            включить режим
+//   --frames N            число кадров (по умолчанию 120)
+//   --size WxH            размер FBO (по умолчанию - размер окна демо)
+//   --output кадр.ppm     сохранить последний кадр
+// Время в этом режиме фиксированное: кадр k соответствует k / 60 секунды,
+// поэтому результат воспроизводим. Сборка: дополнительно -lEGL.
+
+namespace Headless {
+
+struct Options {
+    bool enabled;
+    int frames;
+    int width;
+    int height;
+    const char* output;
+    bool coreProfile;       // false - профиль совместимости (для glBegin/glEnd)
+};
+
+inline Options parseArgs(int argc, char** argv, int width, int height, bool coreProfile = true) {
+    Options options = { false, 120, width, height, nullptr, coreProfile };
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--headless") == 0) {
+            options.enabled = true;
+        }
+        else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            options.frames = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            int w = 0, h = 0;
+            if (std::sscanf(argv[++i], "%dx%d", &w, &h) == 2 && w > 0 && h > 0) {
+                options.width = w;
+                options.height = h;
+            }
+        }
+        else if (std::strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            options.output = argv[++i];
+        }
+    }
+    return options;
+}
+
+class Context {
+private:
+    Options options;
+    EGLDisplay display;
+    EGLContext context;
+    unsigned int framebuffer;
+    unsigned int colorBuffer;
+    unsigned int depthBuffer;
+    int frame;
+    std::chrono::steady_clock::time_point start;
+
+    /*
+    Выбор дисплея EGL:
+    1. EGL_MESA_platform_surfaceless - ни X11, ни Wayland, ни DRM-устройства не нужны
+    2. Иначе дисплей по умолчанию (драйвер сам выберет платформу)
+    */
+    static EGLDisplay openDisplay() {
+        const char* extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+        if (extensions && std::strstr(extensions, "EGL_MESA_platform_surfaceless")) {
+            PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+                (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+            if (getPlatformDisplay) {
+                EGLDisplay result = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+                if (result != EGL_NO_DISPLAY) return result;
+            }
+        }
+        return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+
+public:
+    Context() : display(EGL_NO_DISPLAY), context(EGL_NO_CONTEXT),
+        framebuffer(0), colorBuffer(0), depthBuffer(0), frame(0) {
+        options = Options{ false, 0, 0, 0, nullptr, true };
+    }
+
+    ~Context() {
+        if (framebuffer) {
+            glDeleteFramebuffers(1, &framebuffer);
+            glDeleteRenderbuffers(1, &colorBuffer);
+            glDeleteRenderbuffers(1, &depthBuffer);
+        }
+        if (display != EGL_NO_DISPLAY) {
+            eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+            if (context != EGL_NO_CONTEXT) eglDestroyContext(display, context);
+            eglTerminate(display);
+        }
+    }
+
+    Context(const Context&) = delete;
+    Context& operator=(const Context&) = delete;
+
+    // Создать контекст и FBO; после успешного вызова контекст текущий и GLEW инициализирован
+    bool create(const Options& opts) {
+        options = opts;
+
+        display = openDisplay();
+        if (display == EGL_NO_DISPLAY || !eglInitialize(display, NULL, NULL)) {
+            std::cerr << "Не удалось инициализировать EGL" << std::endl;
+            return false;
+        }
+        if (!eglBindAPI(EGL_OPENGL_API)) {
+            std::cerr << "EGL: OpenGL API недоступен" << std::endl;
+            return false;
+        }
+
+        // Поверхность не нужна, но контексту нужна совместимая конфигурация
+        const EGLint configAttribs[] = {
+            EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+            EGL_SURFACE_TYPE, 0,
+            EGL_NONE
+        };
+        EGLConfig config;
+        EGLint configCount = 0;
+        if (!eglChooseConfig(display, configAttribs, &config, 1, &configCount) || configCount == 0) {
+            std::cerr << "EGL: нет подходящей конфигурации" << std::endl;
+            return false;
+        }
+
+        const EGLint coreAttribs[] = {
+            EGL_CONTEXT_MAJOR_VERSION, 3,
+            EGL_CONTEXT_MINOR_VERSION, 3,
+            EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+            EGL_NONE
+        };
+        const EGLint compatibilityAttribs[] = {
+            EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_COMPATIBILITY_PROFILE_BIT,
+            EGL_NONE
+        };
+        context = eglCreateContext(display, config, EGL_NO_CONTEXT,
+            options.coreProfile ? coreAttribs : compatibilityAttribs);
+        if (context == EGL_NO_CONTEXT ||
+            !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+            std::cerr << "Не удалось создать контекст OpenGL через EGL" << std::endl;
+            return false;
+        }
+
+        // GLEW без GLX-дисплея может вернуть ошибку уже после загрузки функций ядра
+        glewExperimental = GL_TRUE;
+        GLenum glewStatus = glewInit();
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+        if (glewStatus == GLEW_ERROR_NO_GLX_DISPLAY) glewStatus = GLEW_OK;
+#endif
+        if (glewStatus != GLEW_OK) {
+            std::cerr << "Не удалось инициализировать GLEW" << std::endl;
+            return false;
+        }
+
+        // Внеэкранный буфер кадра: цвет + глубина/трафарет
+        glGenFramebuffers(1, &framebuffer);
+        glGenRenderbuffers(1, &colorBuffer);
+        glGenRenderbuffers(1, &depthBuffer);
+
+        glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, options.width, options.height);
+        glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, options.width, options.height);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            std::cerr << "Внеэкранный буфер кадра неполон" << std::endl;
+            return false;
+        }
+        glViewport(0, 0, options.width, options.height);
+
+        std::cout << "Безоконный режим: " << glGetString(GL_RENDERER) << ", "
+            << options.width << "x" << options.height << ", кадров: " << options.frames << std::endl;
+        return true;
+    }
+
+    // Условие основного цикла (вместо !glfwWindowShouldClose): true, пока кадры не кончились
+    bool nextFrame() {
+        if (frame == 0) start = std::chrono::steady_clock::now();
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        return frame++ < options.frames;
+    }
+
+    // Время текущего кадра в секундах (вместо glfwGetTime)
+    double getTime() const { return (frame > 0 ? frame - 1 : 0) / 60.0; }
+
+    int getWidth() const { return options.width; }
+    int getHeight() const { return options.height; }
+
+    // Дождаться GPU, вывести время и сохранить последний кадр (P6 PPM)
+    void finish() {
+        glFinish();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        int frames = std::min(frame, options.frames);
+        std::cout << "Кадров: " << frames << ", всего " << seconds * 1000.0 << " мс, "
+            << (frames > 0 ? seconds * 1000.0 / frames : 0.0) << " мс/кадр" << std::endl;
+
+        if (!options.output) return;
+
+        int w = options.width, h = options.height;
+        std::vector<unsigned char> pixels((size_t)w * h * 4);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, w, h, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+        std::ofstream file(options.output, std::ios::binary);
+        if (!file) {
+            std::cerr << "Не удалось открыть " << options.output << std::endl;
+            return;
+        }
+        file << "P6\n" << w << " " << h << "\n255\n";
+        // В OpenGL первая строка - нижняя
+        std::vector<unsigned char> row((size_t)w * 3);
+        for (int y = h - 1; y >= 0; y--) {
+            const unsigned char* src = &pixels[(size_t)y * w * 4];
+            for (int x = 0; x < w; x++) {
+                row[x * 3] = src[x * 4];
+                row[x * 3 + 1] = src[x * 4 + 1];
+                row[x * 3 + 2] = src[x * 4 + 2];
+            }
+            file.write((const char*)row.data(), row.size());
+        }
+    }
+};
+
+}  // namespace Headless
@@ -0,0 +1,236 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <vector>
+#include <algorithm>
+
+// ============================================
+// Временной ряд с пирамидой min/max и прореживанием для графика
+// ============================================
+
+// Отсчёты идут с постоянным шагом (x = start + i * step), поэтому хранится только y -
+// блоками по CHUNK_SIZE значений: дописывание не копирует уже накопленное. Над рядом
+// строится пирамида min/max, и min/max любого диапазона считается за O(log n).
+// Для отрисовки ряд прореживается под ширину экрана: сколько бы отсчётов ни попало
+// в окно просмотра, на выходе не больше 2 точек на столбец пикселей.
+
+namespace TimeSeries {
+
+enum class Method {
+    MinMax,   // по две точки (min и max) на столбец - огибающая без пропуска пиков
+    LTTB      // Largest-Triangle-Three-Buckets - одна точка на столбец, форма кривой
+};
+
+struct Range {
+    float minValue;
+    float maxValue;
+};
+
+class Series {
+public:
+    static const size_t CHUNK_BITS = 16;
+    static const size_t CHUNK_SIZE = size_t(1) << CHUNK_BITS;
+    static const size_t BASE = 64;       // отсчётов в узле нижнего уровня пирамиды
+    static const size_t FANOUT = 8;      // узлов уровня в узле следующего
+
+private:
+    double start, step;
+    size_t count;
+    std::vector<std::unique_ptr<float[]>> chunks;
+    std::vector<std::vector<Range>> levels;   // уровень L: узлы по BASE * FANOUT^L отсчётов
+
+    static void merge(Range& r, float lo, float hi) {
+        r.minValue = std::min(r.minValue, lo);
+        r.maxValue = std::max(r.maxValue, hi);
+    }
+
+    // Закончился блок из BASE отсчётов - узел уровня 0, и дальше вверх, пока группы полны
+    void completeBlock() {
+        size_t first = count - BASE;
+        Range node = { std::numeric_limits<float>::max(), -std::numeric_limits<float>::max() };
+        for (size_t i = first; i < count; i++) merge(node, at(i), at(i));
+
+        for (size_t level = 0;; level++) {
+            if (levels.size() <= level) levels.emplace_back();
+            std::vector<Range>& nodes = levels[level];
+            nodes.push_back(node);
+            if (nodes.size() % FANOUT != 0) break;
+
+            node = nodes[nodes.size() - FANOUT];
+            for (size_t i = nodes.size() - FANOUT + 1; i < nodes.size(); i++) {
+                merge(node, nodes[i].minValue, nodes[i].maxValue);
+            }
+        }
+    }
+
+    size_t indexAtOrBefore(double x) const {
+        double i = std::floor((x - start) / step);
+        return (size_t)std::min(std::max(i, 0.0), (double)count);
+    }
+
+public:
+    Series(double start = 0.0, double step = 1.0) : start(start), step(step), count(0) {}
+
+    void append(float y) {
+        if ((count & (CHUNK_SIZE - 1)) == 0) chunks.emplace_back(new float[CHUNK_SIZE]);
+        chunks.back()[count & (CHUNK_SIZE - 1)] = y;
+        count++;
+        if (count % BASE == 0) completeBlock();
+    }
+
+    float at(size_t i) const { return chunks[i >> CHUNK_BITS][i & (CHUNK_SIZE - 1)]; }
+    double timeAt(size_t i) const { return start + step * (double)i; }
+    size_t size() const { return count; }
+    double getStart() const { return start; }
+    double getStep() const { return step; }
+    double getEnd() const { return count == 0 ? start : timeAt(count - 1); }
+
+    /*
+    min/max отсчётов [first, last):
+    1. Неполные блоки с краёв - перебором отсчётов (не больше BASE - 1 с каждой стороны)
+    2. Дальше на каждом уровне с краёв берутся узлы, пока границы не выровняются
+       на узел следующего уровня (не больше FANOUT - 1 с каждой стороны)
+    3. Узлы существуют только для полных блоков - граница last не выходит за
+       дописанные данные, так что берутся только они
+    */
+    Range rangeMinMax(size_t first, size_t last) const {
+        Range r = { std::numeric_limits<float>::max(), -std::numeric_limits<float>::max() };
+        last = std::min(last, count);
+        while (first < last && first % BASE != 0) { float y = at(first++); merge(r, y, y); }
+        while (last > first && last % BASE != 0) { float y = at(--last); merge(r, y, y); }
+
+        size_t nodeSize = BASE;
+        for (size_t level = 0; first < last; level++, nodeSize *= FANOUT) {
+            const std::vector<Range>& nodes = levels[level];
+            while (first < last && (first / nodeSize) % FANOUT != 0) {
+                const Range& node = nodes[first / nodeSize];
+                merge(r, node.minValue, node.maxValue);
+                first += nodeSize;
+            }
+            while (last > first && (last / nodeSize) % FANOUT != 0) {
+                const Range& node = nodes[last / nodeSize - 1];
+                merge(r, node.minValue, node.maxValue);
+                last -= nodeSize;
+            }
+        }
+        return r;
+    }
+
+    /*
+    Прореживание окна [x0, x1] под columns столбцов пикселей. Результат - пары (x, y),
+    x отсчитывается от x0: float на больших временах теряет точность, а смещение
+    окна удобнее отдать в матрицу преобразования.
+    1. Отсчёты окна плюс по одному соседнему с каждой стороны - линия уходит за край
+    2. Отсчётов не больше 2 * columns - выдаются как есть
+    3. MinMax: на каждый столбец min и max по пирамиде; первой идёт точка, ближе
+       к предыдущей - вертикальные штрихи столбцов не перекрещиваются
+    4. LTTB: кандидаты - те же min/max, но по 4 корзины на столбец; из кандидатов
+       LTTB выбирает по точке на столбец. Перебор сырых отсчётов был бы O(n),
+       а так работа зависит только от ширины экрана. LTTB нужны хотя бы 3 точки
+       (края и корзина между ними): при 1-2 столбцах вместо него MinMax
+    Возвращает число точек.
+    */
+    size_t decimate(double x0, double x1, int columns, Method method, std::vector<float>& out) const {
+        out.clear();
+        if (count == 0 || columns < 1 || x1 <= x0) return 0;
+
+        size_t first = indexAtOrBefore(x0);
+        size_t last = std::min(indexAtOrBefore(x1) + 2, count);
+        if (first >= last) return 0;
+        size_t visible = last - first;
+
+        if (visible <= (size_t)columns * 2) {
+            out.reserve(visible * 2);
+            for (size_t i = first; i < last; i++) {
+                out.push_back((float)(timeAt(i) - x0));
+                out.push_back(at(i));
+            }
+            return visible;
+        }
+
+        if (method == Method::MinMax || columns < 3) {
+            appendMinMax(first, last, (size_t)columns, x0, out);
+            return out.size() / 2;
+        }
+
+        std::vector<float> candidates;
+        appendMinMax(first, last, (size_t)columns * 4, x0, candidates);
+        lttb(candidates, (size_t)columns, out);
+        return out.size() / 2;
+    }
+
+private:
+    void appendMinMax(size_t first, size_t last, size_t buckets, double x0, std::vector<float>& out) const {
+        size_t visible = last - first;
+        buckets = std::min(buckets, visible);
+        out.reserve(out.size() + buckets * 4);
+        float previous = at(first);
+        for (size_t b = 0; b < buckets; b++) {
+            size_t a = first + visible * b / buckets;
+            size_t e = first + visible * (b + 1) / buckets;
+            Range r = rangeMinMax(a, e);
+            float x = (float)(0.5 * (timeAt(a) + timeAt(e - 1)) - x0);
+            bool minFirst = std::fabs(previous - r.minValue) <= std::fabs(previous - r.maxValue);
+            float y0 = minFirst ? r.minValue : r.maxValue;
+            float y1 = minFirst ? r.maxValue : r.minValue;
+            out.push_back(x); out.push_back(y0);
+            if (y1 != y0) { out.push_back(x); out.push_back(y1); }
+            previous = y1;
+        }
+    }
+
+    /*
+    LTTB по точкам points (пары x, y), threshold точек на выходе:
+    1. Первая и последняя точки остаются
+    2. Остальные делятся на threshold - 2 корзины; из каждой берётся точка с
+       наибольшей площадью треугольника (выбранная в прошлой корзине, кандидат,
+       среднее следующей корзины)
+    */
+    static void lttb(const std::vector<float>& points, size_t threshold, std::vector<float>& out) {
+        size_t n = points.size() / 2;
+        if (threshold >= n || threshold < 3) {
+            out = points;
+            return;
+        }
+        out.reserve(threshold * 2);
+        out.push_back(points[0]); out.push_back(points[1]);
+
+        double bucketSize = (double)(n - 2) / (double)(threshold - 2);
+        size_t selected = 0;
+        for (size_t b = 0; b < threshold - 2; b++) {
+            size_t bucketStart = (size_t)(b * bucketSize) + 1;
+            size_t bucketEnd = std::min((size_t)((b + 1) * bucketSize) + 1, n - 1);
+            size_t nextStart = bucketEnd;
+            size_t nextEnd = std::min((size_t)((b + 2) * bucketSize) + 1, n);
+
+            double avgX = 0.0, avgY = 0.0;
+            for (size_t i = nextStart; i < nextEnd; i++) {
+                avgX += points[i * 2];
+                avgY += points[i * 2 + 1];
+            }
+            size_t nextCount = std::max<size_t>(nextEnd - nextStart, 1);
+            avgX /= nextCount;
+            avgY /= nextCount;
+
+            double ax = points[selected * 2], ay = points[selected * 2 + 1];
+            double bestArea = -1.0;
+            size_t best = bucketStart;
+            for (size_t i = bucketStart; i < bucketEnd; i++) {
+                double area = std::fabs((ax - avgX) * (points[i * 2 + 1] - ay) -
+                    (ax - points[i * 2]) * (avgY - ay));
+                if (area > bestArea) {
+                    bestArea = area;
+                    best = i;
+                }
+            }
+            out.push_back(points[best * 2]); out.push_back(points[best * 2 + 1]);
+            selected = best;
+        }
+        out.push_back(points[(n - 1) * 2]); out.push_back(points[(n - 1) * 2 + 1]);
+    }
+};
+
+}  // namespace TimeSeries
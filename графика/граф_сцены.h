@@ -0,0 +1,153 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <vector>
+#include <glm/glm.hpp>
+
+// ============================================
+// Граф сцены 2D: локальные TRS и кэш мировых матриц
+// ============================================
+
+// Узлы лежат в плоских массивах, родитель всегда раньше детей: узел добавляется
+// только к уже существующему родителю, поэтому индекс узла - его дескриптор.
+// Изменение локального преобразования ставит флаг; update() одним проходом по
+// массиву пересчитывает мировые матрицы только у изменённых узлов и их потомков.
+// Неподвижные поддеревья после первого кадра не стоят ни одного умножения.
+// Матрицы - glm::mat3 однородных 2D-координат: столбцы - оси и перенос, поворот на угол a
+// записан как m[0][1] = -sin a, m[1][0] = sin a.
+
+namespace SceneGraph {
+
+typedef uint32_t NodeId;
+const NodeId NO_PARENT = 0xFFFFFFFFu;
+
+// Локальное преобразование: масштаб и поворот вокруг pivot, затем перенос
+struct Transform {
+    glm::vec2 translation = glm::vec2(0.0f);
+    float rotation = 0.0f;
+    glm::vec2 scale = glm::vec2(1.0f);
+    glm::vec2 pivot = glm::vec2(0.0f);
+};
+
+/*
+T(translation) * T(pivot) * R * S * T(-pivot) в явном виде, без трёх произведений mat3:
+  линейная часть  A = R * S
+  перенос         translation + pivot - A * pivot
+*/
+inline glm::mat3 toMatrix(const Transform& t) {
+    float c = std::cos(t.rotation), s = std::sin(t.rotation);
+    glm::mat3 m(1.0f);
+    m[0][0] = c * t.scale.x;  m[0][1] = -s * t.scale.x;
+    m[1][0] = s * t.scale.y;  m[1][1] = c * t.scale.y;
+    m[2][0] = t.translation.x + t.pivot.x - (m[0][0] * t.pivot.x + m[1][0] * t.pivot.y);
+    m[2][1] = t.translation.y + t.pivot.y - (m[0][1] * t.pivot.x + m[1][1] * t.pivot.y);
+    return m;
+}
+
+// parent * local для аффинных матриц: нижняя строка (0, 0, 1) не умножается
+inline glm::mat3 multiplyAffine(const glm::mat3& a, const glm::mat3& b) {
+    glm::mat3 m(1.0f);
+    for (int col = 0; col < 3; col++) {
+        m[col][0] = a[0][0] * b[col][0] + a[1][0] * b[col][1];
+        m[col][1] = a[0][1] * b[col][0] + a[1][1] * b[col][1];
+    }
+    m[2][0] += a[2][0];
+    m[2][1] += a[2][1];
+    return m;
+}
+
+class Scene {
+private:
+    enum : uint8_t { LOCAL_DIRTY = 1, WORLD_CHANGED = 2 };
+
+    std::vector<NodeId> parents;
+    std::vector<Transform> locals;
+    std::vector<glm::mat3> localMatrices;
+    std::vector<glm::mat3> worldMatrices;
+    std::vector<uint8_t> flags;
+    size_t lastUpdated;
+
+public:
+    Scene() : lastUpdated(0) {}
+
+    void reserve(size_t count) {
+        parents.reserve(count);
+        locals.reserve(count);
+        localMatrices.reserve(count);
+        worldMatrices.reserve(count);
+        flags.reserve(count);
+    }
+
+    // parent - уже добавленный узел или NO_PARENT
+    NodeId add(NodeId parent, const Transform& local = Transform()) {
+        NodeId id = (NodeId)parents.size();
+        parents.push_back(parent < id ? parent : NO_PARENT);
+        locals.push_back(local);
+        localMatrices.push_back(glm::mat3(1.0f));
+        worldMatrices.push_back(glm::mat3(1.0f));
+        flags.push_back(LOCAL_DIRTY);
+        return id;
+    }
+
+    const Transform& getLocal(NodeId node) const { return locals[node]; }
+
+    void setLocal(NodeId node, const Transform& local) {
+        locals[node] = local;
+        flags[node] |= LOCAL_DIRTY;
+    }
+    void setTranslation(NodeId node, float x, float y) {
+        locals[node].translation = glm::vec2(x, y);
+        flags[node] |= LOCAL_DIRTY;
+    }
+    void setRotation(NodeId node, float angle) {
+        locals[node].rotation = angle;
+        flags[node] |= LOCAL_DIRTY;
+    }
+    void setScale(NodeId node, float x, float y) {
+        locals[node].scale = glm::vec2(x, y);
+        flags[node] |= LOCAL_DIRTY;
+    }
+    void setPivot(NodeId node, float x, float y) {
+        locals[node].pivot = glm::vec2(x, y);
+        flags[node] |= LOCAL_DIRTY;
+    }
+
+    /*
+    Пересчёт мировых матриц (раз в кадр, перед отрисовкой):
+    1. Узлы идут по порядку массива - родитель уже обработан в этом же проходе
+    2. Узел пересчитывается, если изменился он сам (LOCAL_DIRTY) или мировая
+       матрица родителя (WORLD_CHANGED, выставлен чуть раньше в этом проходе)
+    3. Локальная матрица строится заново только при LOCAL_DIRTY, иначе берётся из кэша
+    4. WORLD_CHANGED остаётся до следующего update() - по нему видно, чью матрицу
+       нужно заново отправить на GPU
+    Возвращает число пересчитанных узлов.
+    */
+    size_t update() {
+        size_t updated = 0;
+        for (size_t i = 0; i < parents.size(); i++) {
+            uint8_t f = flags[i];
+            NodeId parent = parents[i];
+            bool parentChanged = parent != NO_PARENT && (flags[parent] & WORLD_CHANGED);
+            if (!(f & LOCAL_DIRTY) && !parentChanged) {
+                flags[i] = 0;
+                continue;
+            }
+            if (f & LOCAL_DIRTY) localMatrices[i] = toMatrix(locals[i]);
+            worldMatrices[i] = parent == NO_PARENT ? localMatrices[i] :
+                multiplyAffine(worldMatrices[parent], localMatrices[i]);
+            flags[i] = WORLD_CHANGED;
+            updated++;
+        }
+        lastUpdated = updated;
+        return updated;
+    }
+
+    const glm::mat3& getWorld(NodeId node) const { return worldMatrices[node]; }
+    bool worldChanged(NodeId node) const { return (flags[node] & WORLD_CHANGED) != 0; }
+    NodeId getParent(NodeId node) const { return parents[node]; }
+    size_t size() const { return parents.size(); }
+    size_t getLastUpdated() const { return lastUpdated; }
+};
+
+}  // namespace SceneGraph
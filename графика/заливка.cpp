@@ -5,6 +5,7 @@ lude <iostream>
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
+#include "безоконный_режим.h"
 
 class FloodFill {
 private:
@@ -293,29 +294,39 @@ void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods
     }
 }
 
-int main() {
-    if (!glfwInit()) {
-        std::cerr << "Failed to initialize GLFW" << std::endl;
-        return -1;
-    }
+int main(int argc, char** argv) {
+    // --headless: без окна, рисование во внеэкранный буфер заданное число кадров
+    Headless::Options headless = Headless::parseArgs(argc, argv, 800, 600, false);
+    Headless::Context offscreen;
+    GLFWwindow* window = nullptr;
 
-    GLFWwindow* window = glfwCreateWindow(800, 600, "Flood Fill Algorithm - OpenGL", NULL, NULL);
-    if (!window) {
-        std::cerr << "Failed to create GLFW window" << std::endl;
-        glfwTerminate();
-        return -1;
+    if (headless.enabled) {
+        if (!offscreen.create(headless)) return -1;
     }
+    else {
+        if (!glfwInit()) {
+            std::cerr << "Failed to initialize GLFW" << std::endl;
+            return -1;
+        }
 
-    glfwMakeContextCurrent(window);
-    glfwSwapInterval(1);
+        window = glfwCreateWindow(800, 600, "Flood Fill Algorithm - OpenGL", NULL, NULL);
+        if (!window) {
+            std::cerr << "Failed to create GLFW window" << std::endl;
+            glfwTerminate();
+            return -1;
+        }
 
-    if (glewInit() != GLEW_OK) {
-        std::cerr << "Failed to initialize GLEW" << std::endl;
-        return -1;
-    }
+        glfwMakeContextCurrent(window);
+        glfwSwapInterval(1);
+
+        if (glewInit() != GLEW_OK) {
+            std::cerr << "Failed to initialize GLEW" << std::endl;
+            return -1;
+        }
 
-    glfwSetMouseButtonCallback(window, mouseButtonCallback);
-    glfwSetKeyCallback(window, keyCallback);
+        glfwSetMouseButtonCallback(window, mouseButtonCallback);
+        glfwSetKeyCallback(window, keyCallback);
+    }
 
     glEnable(GL_TEXTURE_2D);
     glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
@@ -334,16 +345,23 @@ int main() {
     std::cout << "  ПРОБЕЛ - сброс изображения" << std::endl;
     std::cout << "  ESC - выход" << std::endl;
 
-    while (!glfwWindowShouldClose(window)) {
+    while (headless.enabled ? offscreen.nextFrame() : !glfwWindowShouldClose(window)) {
         glClear(GL_COLOR_BUFFER_BIT);
         floodFill->render();
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        if (!headless.enabled) {
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+        }
     }
 
     delete floodFill;
-    glfwDestroyWindow(window);
-    glfwTerminate();
+    if (headless.enabled) {
+        offscreen.finish();
+    }
+    else {
+        glfwDestroyWindow(window);
+        glfwTerminate();
+    }
 
     return 0;
 }
\ No newline at end of file
@@ -2,9 +2,16 @@
 #include <GLFW/glfw3.h>
 #include <iostream>
 #include <cmath>
+#include <cstring>
+#include <chrono>
+#include <vector>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include "безоконный_режим.h"
+#include "граф_сцены.h"
+#include "поворот_спрайта.h"
+#include "профилировщик.h"
 
 // Вершинный шейдер с матрицей вращения
 const char* vertexShaderSource = R"(
@@ -53,75 +60,72 @@ unsigned int indices[] = {
     2, 3, 0   // Второй треугольник
 };
 
-// Класс для создания матрицы вращения
-class RotationMatrix {
-public:
-    // Создание матрицы вращения 2D
-    static glm::mat3 create2DRotation(float angle) {
-        float cosA = cos(angle);
-        float sinA = sin(angle);
-
-        // Матрица вращения 2D (3x3 для однородных координат)
-        // [ cos  -sin  0 ]
-        // [ sin   cos  0 ]
-        // [  0     0   1 ]
-
-        glm::mat3 rotation = glm::mat3(1.0f);
-        rotation[0][0] = cosA;
-        rotation[0][1] = -sinA;
-        rotation[1][0] = sinA;
-        rotation[1][1] = cosA;
-
-        return rotation;
+// Спрайт квадрата для программной отрисовки: цвета вершин смешаны так же, как на GPU -
+// отдельно в треугольниках (0, 1, 2) и (2, 3, 0). Первая строка спрайта - верхняя сторона
+SpriteRotation::Image createSquareSprite(int size) {
+    SpriteRotation::Image image(size, size);
+    const float* bottomLeft = &vertices[2];
+    const float* bottomRight = &vertices[7];
+    const float* topRight = &vertices[12];
+    const float* topLeft = &vertices[17];
+    for (int y = 0; y < size; y++) {
+        float v = 1.0f - (y + 0.5f) / size;  // снизу вверх, как в вершинах
+        for (int x = 0; x < size; x++) {
+            float u = (x + 0.5f) / size;
+            int rgb[3];
+            for (int c = 0; c < 3; c++) {
+                float color = u >= v ?
+                    bottomLeft[c] + (bottomRight[c] - bottomLeft[c]) * u + (topRight[c] - bottomRight[c]) * v :
+                    bottomLeft[c] + (topRight[c] - topLeft[c]) * u + (topLeft[c] - bottomLeft[c]) * v;
+                rgb[c] = (int)(color * 255.0f + 0.5f);
+            }
+            image.row(y)[x] = SpriteRotation::packRGBA(rgb[0], rgb[1], rgb[2], 255);
+        }
     }
+    return image;
+}
 
-    // Создание матрицы вращения вокруг произвольной точки
-    static glm::mat3 createRotationAroundPoint(float angle, float centerX, float centerY) {
-        // Композиция трех матриц:
-        // 1. Перенос в начало координат
-        // 2. Вращение
-        // 3. Обратный перенос
-
-        glm::mat3 translateToOrigin = glm::mat3(1.0f);
-        translateToOrigin[2][0] = -centerX;
-        translateToOrigin[2][1] = -centerY;
-
-        glm::mat3 rotation = create2DRotation(angle);
-
-        glm::mat3 translateBack = glm::mat3(1.0f);
-        translateBack[2][0] = centerX;
-        translateBack[2][1] = centerY;
-
-        return translateBack * rotation * translateToOrigin;
+int main(int argc, char** argv) {
+    // --headless: без окна, рисование во внеэкранный буфер заданное число кадров
+    Headless::Options headless = Headless::parseArgs(argc, argv, 800, 600);
+    // --software кадр.ppm: та же сцена дополнительно рисуется на CPU в кадр в памяти
+    const char* softwareOutput = nullptr;
+    for (int i = 1; i + 1 < argc; i++) {
+        if (std::strcmp(argv[i], "--software") == 0) softwareOutput = argv[i + 1];
     }
-};
+    Headless::Context offscreen;
+    GLFWwindow* window = nullptr;
 
-int main() {
-    // Инициализация GLFW
-    if (!glfwInit()) {
-        std::cerr << "Failed to initialize GLFW" << std::endl;
-        return -1;
+    if (headless.enabled) {
+        if (!offscreen.create(headless)) return -1;
     }
+    else {
+        // Инициализация GLFW
+        if (!glfwInit()) {
+            std::cerr << "Failed to initialize GLFW" << std::endl;
+            return -1;
+        }
 
-    // Настройка GLFW
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-    // Создание окна
-    GLFWwindow* window = glfwCreateWindow(800, 600, "Rotating Square - Rotation Matrix", NULL, NULL);
-    if (!window) {
-        std::cerr << "Failed to create GLFW window" << std::endl;
-        glfwTerminate();
-        return -1;
-    }
+        // Настройка GLFW
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+        // Создание окна
+        window = glfwCreateWindow(800, 600, "Rotating Square - Rotation Matrix", NULL, NULL);
+        if (!window) {
+            std::cerr << "Failed to create GLFW window" << std::endl;
+            glfwTerminate();
+            return -1;
+        }
 
-    glfwMakeContextCurrent(window);
+        glfwMakeContextCurrent(window);
 
-    // Инициализация GLEW
-    if (glewInit() != GLEW_OK) {
-        std::cerr << "Failed to initialize GLEW" << std::endl;
-        return -1;
+        // Инициализация GLEW
+        if (glewInit() != GLEW_OK) {
+            std::cerr << "Failed to initialize GLEW" << std::endl;
+            return -1;
+        }
     }
 
     // Компиляция шейдеров
@@ -176,6 +180,63 @@ int main() {
     float rotationCenterX = 0.0f;  // Центр вращения X
     float rotationCenterY = 0.0f;  // Центр вращения Y
 
+    // Сцена: квадрат, на его углах - вращающиеся спутники со своими лунами, в углу
+    // экрана - неподвижная цепочка. Мировые матрицы пересчитываются только у изменённых
+    // узлов и их потомков; цепочка после первого кадра не стоит ни одного умножения
+    SceneGraph::Scene scene;
+    SceneGraph::NodeId square = scene.add(SceneGraph::NO_PARENT);
+
+    const float corners[4][2] = { { -0.5f, -0.5f }, { 0.5f, -0.5f }, { 0.5f, 0.5f }, { -0.5f, 0.5f } };
+    std::vector<SceneGraph::NodeId> satellites;
+    for (int i = 0; i < 4; i++) {
+        SceneGraph::Transform satellite;
+        satellite.translation = glm::vec2(corners[i][0], corners[i][1]);
+        satellite.scale = glm::vec2(0.25f);
+        satellites.push_back(scene.add(square, satellite));
+
+        SceneGraph::Transform moon;
+        moon.translation = glm::vec2(0.9f, 0.0f);
+        moon.scale = glm::vec2(0.4f);
+        scene.add(satellites.back(), moon);
+    }
+
+    SceneGraph::Transform chainLink;
+    chainLink.translation = glm::vec2(-0.85f, 0.8f);
+    chainLink.scale = glm::vec2(0.12f);
+    SceneGraph::NodeId link = scene.add(SceneGraph::NO_PARENT, chainLink);
+    for (int i = 1; i < 8; i++) {
+        chainLink.translation = glm::vec2(1.3f, 0.0f);
+        chainLink.rotation = 0.25f;
+        chainLink.scale = glm::vec2(0.9f);
+        link = scene.add(link, chainLink);
+    }
+    size_t updatedNodes = 0, frames = 0;
+
+    // Программный кадр: спрайт квадрата накладывается той же мировой матрицей узла,
+    // дополненной переходами "пиксели спрайта -> локальные координаты" и "NDC -> пиксели кадра"
+    const int spriteSize = 256;
+    SpriteRotation::Sprite squareSprite(createSquareSprite(spriteSize));
+    int softwareWidth = headless.enabled ? offscreen.getWidth() : 800;
+    int softwareHeight = headless.enabled ? offscreen.getHeight() : 600;
+    SpriteRotation::Image softwareFrame;
+    if (softwareOutput) softwareFrame = SpriteRotation::Image(softwareWidth, softwareHeight);
+
+    glm::mat3 spriteToLocal(1.0f);
+    spriteToLocal[0][0] = 1.0f / spriteSize;
+    spriteToLocal[1][1] = -1.0f / spriteSize;
+    spriteToLocal[2][0] = -0.5f;
+    spriteToLocal[2][1] = 0.5f;
+    glm::mat3 ndcToPixels(1.0f);
+    ndcToPixels[0][0] = softwareWidth * 0.5f;
+    ndcToPixels[1][1] = -softwareHeight * 0.5f;
+    ndcToPixels[2][0] = softwareWidth * 0.5f;
+    ndcToPixels[2][1] = softwareHeight * 0.5f;
+    double softwareMilliseconds = 0.0;
+
+    // Время кадра по областям (--profile имя - выгрузка в имя.csv и имя.json)
+    const char* profileOutput = Profiler::parseArgs(argc, argv);
+    Profiler::FrameProfiler profiler;
+
     std::cout << "=== Rotating Square Demo ===" << std::endl;
     std::cout << "Controls:" << std::endl;
     std::cout << "  SPACE - change rotation mode" << std::endl;
@@ -185,7 +246,10 @@ int main() {
     std::cout << "  ESC - exit" << std::endl;
 
     // Основной цикл
-    while (!glfwWindowShouldClose(window)) {
+    while (headless.enabled ? offscreen.nextFrame() : !glfwWindowShouldClose(window)) {
+        // Кадр закрывается следующим beginFrame - в безоконном режиме цикл идёт через continue
+        profiler.beginFrame();
+
         // Очистка экрана
         glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT);
@@ -194,32 +258,57 @@ int main() {
         glUseProgram(shaderProgram);
 
         // Расчет угла вращения
-        float time = glfwGetTime();
+        float time = headless.enabled ? offscreen.getTime() : glfwGetTime();
         float angle = time * rotationSpeed;
 
-        // Создание матрицы вращения в зависимости от режима
-        glm::mat3 rotationMatrix;
-
+        // Точка вращения зависит от режима: граф сцены собирает поворот вокруг pivot
+        // (перенос в начало, поворот, обратный перенос) сразу, без трёх произведений
         switch (rotationMode) {
         case 0:  // Вращение вокруг центра квадрата
-            rotationMatrix = RotationMatrix::create2DRotation(angle);
+            scene.setPivot(square, 0.0f, 0.0f);
             break;
 
         case 1:  // Вращение вокруг левого нижнего угла
-            rotationMatrix = RotationMatrix::createRotationAroundPoint(angle, -0.5f, -0.5f);
+            scene.setPivot(square, -0.5f, -0.5f);
             break;
 
         case 2:  // Вращение вокруг произвольной точки
-            rotationMatrix = RotationMatrix::createRotationAroundPoint(angle, rotationCenterX, rotationCenterY);
+            scene.setPivot(square, rotationCenterX, rotationCenterY);
             break;
         }
+        scene.setRotation(square, angle);
+        for (SceneGraph::NodeId satellite : satellites) scene.setRotation(satellite, -2.0f * angle);
 
-        // Передача матрицы вращения в шейдер
-        glUniformMatrix3fv(rotationMatrixLoc, 1, GL_FALSE, glm::value_ptr(rotationMatrix));
+        profiler.beginCpu("граф сцены");
+        updatedNodes += scene.update();
+        profiler.endCpu();
+        frames++;
 
-        // Отрисовка квадрата
+        // Отрисовка всех узлов сцены одним квадратом с разными матрицами
+        profiler.beginCpu("отрисовка");
+        profiler.beginGpu("отрисовка");
         glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+        for (SceneGraph::NodeId node = 0; node < scene.size(); node++) {
+            glUniformMatrix3fv(rotationMatrixLoc, 1, GL_FALSE, glm::value_ptr(scene.getWorld(node)));
+            glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+        }
+        profiler.endGpu();
+        profiler.endCpu();
+
+        if (softwareOutput) {
+            Profiler::CpuScope scope(profiler, "программный кадр");
+            auto softwareStart = std::chrono::steady_clock::now();
+            softwareFrame.clear(SpriteRotation::packRGBA(51, 77, 77, 255));
+            for (SceneGraph::NodeId node = 0; node < scene.size(); node++) {
+                glm::mat3 world = SceneGraph::multiplyAffine(scene.getWorld(node), spriteToLocal);
+                SpriteRotation::composite(squareSprite, SceneGraph::multiplyAffine(ndcToPixels, world), softwareFrame);
+            }
+            softwareMilliseconds += std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - softwareStart).count();
+        }
+
+        // В безоконном режиме нет ни ввода, ни окна
+        if (headless.enabled) continue;
 
         // Обработка ввода
         if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS) {
@@ -264,14 +353,35 @@ int main() {
         glfwPollEvents();
     }
 
+    profiler.flush();
+    profiler.printSummary(std::cout);
+    if (profileOutput && !profiler.save(profileOutput)) {
+        std::cerr << "Failed to write profile " << profileOutput << std::endl;
+    }
+
+    std::cout << "Scene: " << scene.size() << " nodes, world matrices recomputed per frame: "
+        << (frames ? (double)updatedNodes / frames : 0.0) << std::endl;
+    if (softwareOutput) {
+        std::cout << "CPU sprite rotation: " << (frames ? softwareMilliseconds / frames : 0.0)
+            << " ms/frame (" << softwareWidth << "x" << softwareHeight << ")" << std::endl;
+        if (!softwareFrame.savePPM(softwareOutput)) {
+            std::cerr << "Failed to write " << softwareOutput << std::endl;
+        }
+    }
+
     // Очистка
     glDeleteVertexArrays(1, &VAO);
     glDeleteBuffers(1, &VBO);
     glDeleteBuffers(1, &EBO);
     glDeleteProgram(shaderProgram);
 
-    glfwDestroyWindow(window);
-    glfwTerminate();
+    if (headless.enabled) {
+        offscreen.finish();
+    }
+    else {
+        glfwDestroyWindow(window);
+        glfwTerminate();
+    }
 
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,267 @@
+#pragma once
+#include <GL/glew.h>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include "объекты_gl.h"
+#include "очередь_отрисовки.h"
+
+// ============================================
+// Ломаная на GPU: отрезок = экземпляр, толщина и стыки в шейдере
+// ============================================
+
+// Точки лежат только в VBO (по 2 float). Каждый отрезок рисуется экземпляром из
+// 4 вершин; вершинный шейдер растягивает его в прямоугольник заданной толщины
+// в пикселях. Стык - острый (miter, углы соседних отрезков совпадают) или круглый
+// (round, край считается во фрагментном шейдере). Новые точки дописываются в
+// конец буфера - уже загруженные не передаются повторно.
+// Программа: createShaderProgram(Polyline::vertexShaderSource, Polyline::fragmentShaderSource).
+
+namespace Polyline {
+
+enum class Join { Miter = 0, Round = 1 };
+
+const char* const vertexShaderSource = R"(
+#version 330 core
+layout (location = 0) in vec2 aCorner;   // x: 0 - начало отрезка, 1 - конец; y: сторона -1 / +1
+layout (location = 1) in vec2 iPrev;     // точка до отрезка (= iStart, если её нет)
+layout (location = 2) in vec2 iStart;
+layout (location = 3) in vec2 iEnd;
+layout (location = 4) in vec2 iNext;     // точка после отрезка (= iEnd, если её нет)
+
+uniform mat4 transform;
+uniform vec2 viewportSize;
+uniform float halfWidth;
+uniform int joinStyle;
+uniform float miterLimit;
+
+out vec2 localPos;                        // пиксели: x - вдоль отрезка от начала, y - поперёк
+flat out float segmentLength;
+
+vec2 toPixels(vec2 p) {
+    vec4 clip = transform * vec4(p, 0.0, 1.0);
+    return (clip.xy / clip.w * 0.5 + 0.5) * viewportSize;
+}
+
+void main() {
+    vec2 p0 = toPixels(iPrev), p1 = toPixels(iStart), p2 = toPixels(iEnd), p3 = toPixels(iNext);
+    vec2 segment = p2 - p1;
+    float len = length(segment);
+    vec2 dir = len > 0.0 ? segment / len : vec2(1.0, 0.0);
+    vec2 normal = vec2(-dir.y, dir.x);
+    float w = halfWidth + 1.0;            // пиксель запаса на сглаживание
+    bool atStart = aCorner.x == 0.0;
+    vec2 pos;
+
+    if (joinStyle == 1) {
+        // Капсула: прямоугольник с запасом w за концами, скругление - во фрагментном шейдере
+        float along = atStart ? -w : len + w;
+        pos = p1 + dir * along + normal * aCorner.y * w;
+        localPos = vec2(along, aCorner.y * w);
+    }
+    else {
+        // Острый стык: вершина сдвигается вдоль биссектрисы, чтобы совпасть с соседним отрезком
+        vec2 point = atStart ? p1 : p2;
+        vec2 other = atStart ? p1 - p0 : p3 - p2;
+        vec2 offset = normal * w;
+        if (dot(other, other) > 1e-8) {
+            vec2 sum = normalize(other) + dir;
+            if (dot(sum, sum) > 1e-8) {
+                vec2 tangent = normalize(sum);
+                vec2 miter = vec2(-tangent.y, tangent.x);
+                offset = miter * w / max(dot(miter, normal), 1.0 / miterLimit);
+            }
+        }
+        pos = point + offset * aCorner.y;
+        localPos = vec2(atStart ? 0.0 : len, aCorner.y * w);
+    }
+
+    segmentLength = len;
+    gl_Position = vec4(pos / viewportSize * 2.0 - 1.0, 0.0, 1.0);
+}
+)";
+
+const char* const fragmentShaderSource = R"(
+#version 330 core
+in vec2 localPos;
+flat in float segmentLength;
+out vec4 FragColor;
+
+uniform float halfWidth;
+uniform int joinStyle;
+uniform vec4 color;
+
+void main() {
+    float d;
+    if (joinStyle == 1) {
+        // Расстояние до отрезка [0, segmentLength] на оси x - круглые концы и стыки
+        d = length(vec2(localPos.x - clamp(localPos.x, 0.0, segmentLength), localPos.y));
+    }
+    else {
+        d = abs(localPos.y);
+    }
+    float alpha = clamp(halfWidth + 0.5 - d, 0.0, 1.0);
+    if (alpha <= 0.0) discard;
+    FragColor = vec4(color.rgb, color.a * alpha);
+}
+)";
+
+/*
+Раскладка буфера точек: [p0, p0, p1, ..., pn-1, pn-1]
+1. Крайние точки повторены - у первого и последнего отрезка "соседняя" точка совпадает
+   с концом, шейдер видит нулевой отрезок и делает торец без стыка
+2. Атрибуты 1..4 смотрят в один буфер со сдвигом на 0, 1, 2, 3 точки и divisor = 1:
+   экземпляр i получает (b[i], b[i+1], b[i+2], b[i+3]) = (p[i-1], p[i], p[i+1], p[i+2])
+3. append() пишет новые точки поверх повтора последней и ставит новый повтор -
+   один glBufferSubData на k + 1 точку
+4. Не хватает места - буфер удваивается копированием на GPU (glCopyBufferSubData)
+*/
+class Renderer {
+private:
+    GLHandle::VertexArray VAO;
+    GLHandle::Buffer cornerVBO, pointVBO;
+    size_t pointCount;
+    size_t capacity;                 // в точках, вместе с двумя повторами
+    float lastX, lastY;
+
+    unsigned int program;
+    int transformLoc, viewportLoc, halfWidthLoc, joinLoc, miterLimitLoc, colorLoc;
+    float transform[16];
+    float viewportWidth, viewportHeight;
+    float halfWidth, miterLimit;
+    float color[4];
+    Join join;
+
+    void bindPointAttributes() {
+        glBindVertexArray(VAO.get());
+        glBindBuffer(GL_ARRAY_BUFFER, pointVBO.get());
+        for (int i = 0; i < 4; i++) {
+            glVertexAttribPointer(1 + i, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float),
+                (void*)(uintptr_t)(i * 2 * sizeof(float)));
+            glEnableVertexAttribArray(1 + i);
+            glVertexAttribDivisor(1 + i, 1);
+        }
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    void reserve(size_t points) {
+        if (points <= capacity) return;
+        size_t newCapacity = std::max(points, capacity * 2);
+        GLHandle::Buffer newBuffer = GLHandle::Buffer::generate();
+        glBindBuffer(GL_COPY_WRITE_BUFFER, newBuffer.get());
+        glBufferData(GL_COPY_WRITE_BUFFER, newCapacity * 2 * sizeof(float), NULL, GL_DYNAMIC_DRAW);
+        if (pointCount > 0) {
+            glBindBuffer(GL_COPY_READ_BUFFER, pointVBO.get());
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0,
+                (pointCount + 2) * 2 * sizeof(float));
+            glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        }
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        pointVBO = std::move(newBuffer);
+        capacity = newCapacity;
+        bindPointAttributes();
+    }
+
+public:
+    Renderer() : pointCount(0), capacity(0), lastX(0.0f), lastY(0.0f), program(0),
+        transformLoc(-1), viewportLoc(-1), halfWidthLoc(-1), joinLoc(-1), miterLimitLoc(-1), colorLoc(-1),
+        viewportWidth(800.0f), viewportHeight(600.0f), halfWidth(1.0f), miterLimit(4.0f), join(Join::Miter) {
+        for (int i = 0; i < 16; i++) transform[i] = (i % 5 == 0) ? 1.0f : 0.0f;
+        color[0] = color[1] = color[2] = color[3] = 1.0f;
+    }
+
+    void create(unsigned int shaderProgram, size_t initialPoints = 1024) {
+        static const float corners[] = { 0.0f, -1.0f, 0.0f, 1.0f, 1.0f, -1.0f, 1.0f, 1.0f };
+
+        program = shaderProgram;
+        transformLoc = glGetUniformLocation(program, "transform");
+        viewportLoc = glGetUniformLocation(program, "viewportSize");
+        halfWidthLoc = glGetUniformLocation(program, "halfWidth");
+        joinLoc = glGetUniformLocation(program, "joinStyle");
+        miterLimitLoc = glGetUniformLocation(program, "miterLimit");
+        colorLoc = glGetUniformLocation(program, "color");
+
+        VAO = GLHandle::VertexArray::generate();
+        cornerVBO = GLHandle::Buffer::generate();
+        glBindVertexArray(VAO.get());
+        glBindBuffer(GL_ARRAY_BUFFER, cornerVBO.get());
+        glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        reserve(initialPoints + 2);
+    }
+
+    // xy - count пар (x, y)
+    void append(const float* xy, size_t count) {
+        if (count == 0) return;
+        reserve(pointCount + count + 2);
+
+        // Пишем с места повтора последней точки (для пустой ломаной - с начала, вместе с первым повтором)
+        size_t start = pointCount == 0 ? 0 : pointCount + 1;
+        std::vector<float> tail;
+        tail.reserve((count + 2) * 2);
+        if (pointCount == 0) tail.insert(tail.end(), { xy[0], xy[1] });
+        tail.insert(tail.end(), xy, xy + count * 2);
+        lastX = xy[(count - 1) * 2];
+        lastY = xy[(count - 1) * 2 + 1];
+        tail.insert(tail.end(), { lastX, lastY });
+
+        glBindBuffer(GL_ARRAY_BUFFER, pointVBO.get());
+        glBufferSubData(GL_ARRAY_BUFFER, start * 2 * sizeof(float), tail.size() * sizeof(float), tail.data());
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        pointCount += count;
+    }
+
+    void append(float x, float y) {
+        float xy[2] = { x, y };
+        append(xy, 1);
+    }
+
+    void clear() { pointCount = 0; }
+    size_t size() const { return pointCount; }
+
+    // Преобразование точек в NDC (матрица 4x4 по столбцам, как у glm)
+    void setTransform(const float* matrix) { std::memcpy(transform, matrix, sizeof(transform)); }
+    void setViewport(int width, int height) {
+        viewportWidth = (float)width;
+        viewportHeight = (float)height;
+    }
+    void setWidth(float pixels) { halfWidth = pixels * 0.5f; }
+    void setJoin(Join style, float limit = 4.0f) {
+        join = style;
+        miterLimit = limit;
+    }
+    void setColor(float r, float g, float b, float a = 1.0f) {
+        color[0] = r; color[1] = g; color[2] = b; color[3] = a;
+    }
+
+    // Команда для очереди отрисовки (края сглажены - нужно смешивание)
+    RenderQueue::DrawCommand command() const {
+        RenderQueue::DrawCommand c;
+        c.program = program;
+        c.vertexArray = VAO.get();
+        c.blend = true;
+        c.mode = GL_TRIANGLE_STRIP;
+        c.count = pointCount >= 2 ? 4 : 0;
+        c.instanceCount = (int)(pointCount >= 2 ? pointCount - 1 : 0);
+        c.callback = [](const RenderQueue::DrawCommand& command) {
+            const Renderer* r = (const Renderer*)command.userData;
+            glUniformMatrix4fv(r->transformLoc, 1, GL_FALSE, r->transform);
+            glUniform2f(r->viewportLoc, r->viewportWidth, r->viewportHeight);
+            glUniform1f(r->halfWidthLoc, r->halfWidth);
+            glUniform1i(r->joinLoc, (int)r->join);
+            glUniform1f(r->miterLimitLoc, r->miterLimit);
+            glUniform4fv(r->colorLoc, 1, r->color);
+        };
+        c.userData = this;
+        return c;
+    }
+};
+
+}  // namespace Polyline
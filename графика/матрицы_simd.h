@@ -0,0 +1,377 @@
+#pragma once
+#include <cstddef>
+#include <cstring>
+
+// ============================================
+// Матрицы 4x4 на SSE/AVX (со скалярной веткой)
+// ============================================
+
+// Хранение - 16 float по столбцам (как в OpenGL и SimpleMath): m[col * 4 + row].
+// Набор инструкций выбирается при компиляции:
+//   AVX  - если собрано с -mavx (/arch:AVX), пакетные преобразования по 8 вершин
+//   SSE  - x86-64 всегда, по 4 вершины
+//   иначе (или с MATRIX_SIMD_SCALAR) - обычный C++
+
+#if !defined(MATRIX_SIMD_SCALAR) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define MATRIX_SIMD_SSE 1
+#include <xmmintrin.h>
+#include <emmintrin.h>
+#if defined(__AVX__)
+#define MATRIX_SIMD_AVX 1
+#include <immintrin.h>
+#endif
+#endif
+
+namespace MatrixSIMD {
+
+// out = a * b (out может совпадать с a или b)
+inline void multiply(const float* a, const float* b, float* out) {
+#ifdef MATRIX_SIMD_SSE
+    // Столбец j результата = сумма столбцов a с коэффициентами из столбца j матрицы b
+    __m128 a0 = _mm_loadu_ps(a);
+    __m128 a1 = _mm_loadu_ps(a + 4);
+    __m128 a2 = _mm_loadu_ps(a + 8);
+    __m128 a3 = _mm_loadu_ps(a + 12);
+
+    __m128 r[4];
+    for (int j = 0; j < 4; j++) {
+        const float* bc = b + j * 4;
+        r[j] = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(a0, _mm_set1_ps(bc[0])), _mm_mul_ps(a1, _mm_set1_ps(bc[1]))),
+            _mm_add_ps(_mm_mul_ps(a2, _mm_set1_ps(bc[2])), _mm_mul_ps(a3, _mm_set1_ps(bc[3]))));
+    }
+    for (int j = 0; j < 4; j++) {
+        _mm_storeu_ps(out + j * 4, r[j]);
+    }
+#else
+    float r[16];
+    for (int j = 0; j < 4; j++) {
+        for (int i = 0; i < 4; i++) {
+            r[j * 4 + i] = a[i] * b[j * 4] + a[4 + i] * b[j * 4 + 1] +
+                a[8 + i] * b[j * 4 + 2] + a[12 + i] * b[j * 4 + 3];
+        }
+    }
+    std::memcpy(out, r, sizeof(r));
+#endif
+}
+
+// out = транспонированная m (out может совпадать с m)
+inline void transpose(const float* m, float* out) {
+#ifdef MATRIX_SIMD_SSE
+    __m128 c0 = _mm_loadu_ps(m);
+    __m128 c1 = _mm_loadu_ps(m + 4);
+    __m128 c2 = _mm_loadu_ps(m + 8);
+    __m128 c3 = _mm_loadu_ps(m + 12);
+    _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+    _mm_storeu_ps(out, c0);
+    _mm_storeu_ps(out + 4, c1);
+    _mm_storeu_ps(out + 8, c2);
+    _mm_storeu_ps(out + 12, c3);
+#else
+    float r[16];
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 4; j++) {
+            r[i * 4 + j] = m[j * 4 + i];
+        }
+    }
+    std::memcpy(out, r, sizeof(r));
+#endif
+}
+
+// Скалярное обращение (разложение Лапласа по 2x2 минорам)
+// Возвращает false для вырожденной матрицы
+inline bool inverseScalar(const float* m, float* out) {
+    float s0 = m[0] * m[5] - m[4] * m[1];
+    float s1 = m[0] * m[6] - m[4] * m[2];
+    float s2 = m[0] * m[7] - m[4] * m[3];
+    float s3 = m[1] * m[6] - m[5] * m[2];
+    float s4 = m[1] * m[7] - m[5] * m[3];
+    float s5 = m[2] * m[7] - m[6] * m[3];
+
+    float c5 = m[10] * m[15] - m[14] * m[11];
+    float c4 = m[9] * m[15] - m[13] * m[11];
+    float c3 = m[9] * m[14] - m[13] * m[10];
+    float c2 = m[8] * m[15] - m[12] * m[11];
+    float c1 = m[8] * m[14] - m[12] * m[10];
+    float c0 = m[8] * m[13] - m[12] * m[9];
+
+    float det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+    if (det == 0.0f) return false;
+    float id = 1.0f / det;
+
+    float r[16] = {
+        ( m[5] * c5 - m[6] * c4 + m[7] * c3) * id,
+        (-m[1] * c5 + m[2] * c4 - m[3] * c3) * id,
+        ( m[13] * s5 - m[14] * s4 + m[15] * s3) * id,
+        (-m[9] * s5 + m[10] * s4 - m[11] * s3) * id,
+
+        (-m[4] * c5 + m[6] * c2 - m[7] * c1) * id,
+        ( m[0] * c5 - m[2] * c2 + m[3] * c1) * id,
+        (-m[12] * s5 + m[14] * s2 - m[15] * s1) * id,
+        ( m[8] * s5 - m[10] * s2 + m[11] * s1) * id,
+
+        ( m[4] * c4 - m[5] * c2 + m[7] * c0) * id,
+        (-m[0] * c4 + m[1] * c2 - m[3] * c0) * id,
+        ( m[12] * s4 - m[13] * s2 + m[15] * s0) * id,
+        (-m[8] * s4 + m[9] * s2 - m[11] * s0) * id,
+
+        (-m[4] * c3 + m[5] * c1 - m[6] * c0) * id,
+        ( m[0] * c3 - m[1] * c1 + m[2] * c0) * id,
+        (-m[12] * s3 + m[13] * s1 - m[14] * s0) * id,
+        ( m[8] * s3 - m[9] * s1 + m[10] * s0) * id
+    };
+    std::memcpy(out, r, sizeof(r));
+    return true;
+}
+
+#ifdef MATRIX_SIMD_SSE
+namespace detail {
+
+// Перестановка компонент: результат = (v[x], v[y], v[z], v[w])
+#define MATRIX_SIMD_SWIZZLE(v, x, y, z, w) _mm_shuffle_ps(v, v, _MM_SHUFFLE(w, z, y, x))
+// Результат = (a[x], a[y], b[z], b[w])
+#define MATRIX_SIMD_SHUFFLE(a, b, x, y, z, w) _mm_shuffle_ps(a, b, _MM_SHUFFLE(w, z, y, x))
+
+// Блоки 2x2 хранятся в одном регистре: (m00, m01, m10, m11)
+inline __m128 mat2Mul(__m128 a, __m128 b) {
+    return _mm_add_ps(_mm_mul_ps(a, MATRIX_SIMD_SWIZZLE(b, 0, 3, 0, 3)),
+        _mm_mul_ps(MATRIX_SIMD_SWIZZLE(a, 1, 0, 3, 2), MATRIX_SIMD_SWIZZLE(b, 2, 1, 2, 1)));
+}
+
+// adj(a) * b
+inline __m128 mat2AdjMul(__m128 a, __m128 b) {
+    return _mm_sub_ps(_mm_mul_ps(MATRIX_SIMD_SWIZZLE(a, 3, 3, 0, 0), b),
+        _mm_mul_ps(MATRIX_SIMD_SWIZZLE(a, 1, 1, 2, 2), MATRIX_SIMD_SWIZZLE(b, 2, 3, 0, 1)));
+}
+
+// a * adj(b)
+inline __m128 mat2MulAdj(__m128 a, __m128 b) {
+    return _mm_sub_ps(_mm_mul_ps(a, MATRIX_SIMD_SWIZZLE(b, 3, 0, 3, 0)),
+        _mm_mul_ps(MATRIX_SIMD_SWIZZLE(a, 1, 0, 3, 2), MATRIX_SIMD_SWIZZLE(b, 2, 1, 2, 1)));
+}
+
+}  // namespace detail
+#endif
+
+/*
+Обращение 4x4 блочным методом (формула Фробениуса через 2x2 блоки):
+M = [A B; C D], все 2x2 произведения и определители считаются в регистрах SSE.
+Метод не зависит от порядка хранения: inverse(M^T) = inverse(M)^T.
+Возвращает false для вырожденной матрицы (out не меняется).
+*/
+inline bool inverse(const float* m, float* out) {
+#ifdef MATRIX_SIMD_SSE
+    using namespace detail;
+    __m128 r0 = _mm_loadu_ps(m);
+    __m128 r1 = _mm_loadu_ps(m + 4);
+    __m128 r2 = _mm_loadu_ps(m + 8);
+    __m128 r3 = _mm_loadu_ps(m + 12);
+
+    __m128 A = _mm_movelh_ps(r0, r1);
+    __m128 B = _mm_movehl_ps(r1, r0);
+    __m128 C = _mm_movelh_ps(r2, r3);
+    __m128 D = _mm_movehl_ps(r3, r2);
+
+    // Определители блоков: (detA, detB, detC, detD)
+    __m128 detSub = _mm_sub_ps(
+        _mm_mul_ps(MATRIX_SIMD_SHUFFLE(r0, r2, 0, 2, 0, 2), MATRIX_SIMD_SHUFFLE(r1, r3, 1, 3, 1, 3)),
+        _mm_mul_ps(MATRIX_SIMD_SHUFFLE(r0, r2, 1, 3, 1, 3), MATRIX_SIMD_SHUFFLE(r1, r3, 0, 2, 0, 2)));
+    __m128 detA = MATRIX_SIMD_SWIZZLE(detSub, 0, 0, 0, 0);
+    __m128 detB = MATRIX_SIMD_SWIZZLE(detSub, 1, 1, 1, 1);
+    __m128 detC = MATRIX_SIMD_SWIZZLE(detSub, 2, 2, 2, 2);
+    __m128 detD = MATRIX_SIMD_SWIZZLE(detSub, 3, 3, 3, 3);
+
+    __m128 D_C = mat2AdjMul(D, C);
+    __m128 A_B = mat2AdjMul(A, B);
+    __m128 X = _mm_sub_ps(_mm_mul_ps(detD, A), mat2Mul(B, D_C));
+    __m128 W = _mm_sub_ps(_mm_mul_ps(detA, D), mat2Mul(C, A_B));
+    __m128 Y = _mm_sub_ps(_mm_mul_ps(detB, C), mat2MulAdj(D, A_B));
+    __m128 Z = _mm_sub_ps(_mm_mul_ps(detC, B), mat2MulAdj(A, D_C));
+
+    // det(M) = detA * detD + detB * detC - tr(adj(A)B * adj(D)C)
+    __m128 tr = _mm_mul_ps(A_B, MATRIX_SIMD_SWIZZLE(D_C, 0, 2, 1, 3));
+    tr = _mm_add_ps(tr, _mm_movehl_ps(tr, tr));
+    tr = _mm_add_ss(tr, MATRIX_SIMD_SWIZZLE(tr, 1, 1, 1, 1));
+    float det = _mm_cvtss_f32(_mm_sub_ss(
+        _mm_add_ss(_mm_mul_ss(detA, detD), _mm_mul_ss(detB, detC)), tr));
+    if (det == 0.0f) return false;
+
+    __m128 rDet = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), _mm_set1_ps(det));
+    X = _mm_mul_ps(X, rDet);
+    Y = _mm_mul_ps(Y, rDet);
+    Z = _mm_mul_ps(Z, rDet);
+    W = _mm_mul_ps(W, rDet);
+
+    _mm_storeu_ps(out, MATRIX_SIMD_SHUFFLE(X, Y, 3, 1, 3, 1));
+    _mm_storeu_ps(out + 4, MATRIX_SIMD_SHUFFLE(X, Y, 2, 0, 2, 0));
+    _mm_storeu_ps(out + 8, MATRIX_SIMD_SHUFFLE(Z, W, 3, 1, 3, 1));
+    _mm_storeu_ps(out + 12, MATRIX_SIMD_SHUFFLE(Z, W, 2, 0, 2, 0));
+    return true;
+#else
+    return inverseScalar(m, out);
+#endif
+}
+
+// ============================================
+// Пакетные преобразования вершин одной матрицей
+// ============================================
+
+// w = 1 для позиций (перенос учитывается), w = 0 для направлений/нормалей.
+// Результат - xyz (w отбрасывается, матрица считается аффинной).
+// Для нормалей при неравномерном масштабе передавайте обратную транспонированную матрицу.
+
+/*
+SoA: отдельные массивы x[], y[], z[].
+Каждая компонента результата - 3 умножения со сложением на 8 (AVX) или 4 (SSE) вершины сразу.
+in и out могут совпадать.
+*/
+inline void transformSoA(const float* m, float w,
+    const float* inX, const float* inY, const float* inZ,
+    float* outX, float* outY, float* outZ, size_t count) {
+    size_t i = 0;
+
+#ifdef MATRIX_SIMD_AVX
+    {
+        __m256 m0 = _mm256_set1_ps(m[0]), m1 = _mm256_set1_ps(m[1]), m2 = _mm256_set1_ps(m[2]);
+        __m256 m4 = _mm256_set1_ps(m[4]), m5 = _mm256_set1_ps(m[5]), m6 = _mm256_set1_ps(m[6]);
+        __m256 m8 = _mm256_set1_ps(m[8]), m9 = _mm256_set1_ps(m[9]), m10 = _mm256_set1_ps(m[10]);
+        __m256 tx = _mm256_set1_ps(m[12] * w), ty = _mm256_set1_ps(m[13] * w), tz = _mm256_set1_ps(m[14] * w);
+
+        for (; i + 8 <= count; i += 8) {
+            __m256 x = _mm256_loadu_ps(inX + i);
+            __m256 y = _mm256_loadu_ps(inY + i);
+            __m256 z = _mm256_loadu_ps(inZ + i);
+
+            __m256 rx = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m0, x), _mm256_mul_ps(m4, y)),
+                _mm256_add_ps(_mm256_mul_ps(m8, z), tx));
+            __m256 ry = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m1, x), _mm256_mul_ps(m5, y)),
+                _mm256_add_ps(_mm256_mul_ps(m9, z), ty));
+            __m256 rz = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m2, x), _mm256_mul_ps(m6, y)),
+                _mm256_add_ps(_mm256_mul_ps(m10, z), tz));
+
+            _mm256_storeu_ps(outX + i, rx);
+            _mm256_storeu_ps(outY + i, ry);
+            _mm256_storeu_ps(outZ + i, rz);
+        }
+    }
+#endif
+
+#ifdef MATRIX_SIMD_SSE
+    {
+        __m128 m0 = _mm_set1_ps(m[0]), m1 = _mm_set1_ps(m[1]), m2 = _mm_set1_ps(m[2]);
+        __m128 m4 = _mm_set1_ps(m[4]), m5 = _mm_set1_ps(m[5]), m6 = _mm_set1_ps(m[6]);
+        __m128 m8 = _mm_set1_ps(m[8]), m9 = _mm_set1_ps(m[9]), m10 = _mm_set1_ps(m[10]);
+        __m128 tx = _mm_set1_ps(m[12] * w), ty = _mm_set1_ps(m[13] * w), tz = _mm_set1_ps(m[14] * w);
+
+        for (; i + 4 <= count; i += 4) {
+            __m128 x = _mm_loadu_ps(inX + i);
+            __m128 y = _mm_loadu_ps(inY + i);
+            __m128 z = _mm_loadu_ps(inZ + i);
+
+            __m128 rx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m0, x), _mm_mul_ps(m4, y)),
+                _mm_add_ps(_mm_mul_ps(m8, z), tx));
+            __m128 ry = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m1, x), _mm_mul_ps(m5, y)),
+                _mm_add_ps(_mm_mul_ps(m9, z), ty));
+            __m128 rz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m2, x), _mm_mul_ps(m6, y)),
+                _mm_add_ps(_mm_mul_ps(m10, z), tz));
+
+            _mm_storeu_ps(outX + i, rx);
+            _mm_storeu_ps(outY + i, ry);
+            _mm_storeu_ps(outZ + i, rz);
+        }
+    }
+#endif
+
+    // Хвост (и скалярная ветка)
+    for (; i < count; i++) {
+        float x = inX[i], y = inY[i], z = inZ[i];
+        outX[i] = m[0] * x + m[4] * y + m[8] * z + m[12] * w;
+        outY[i] = m[1] * x + m[5] * y + m[9] * z + m[13] * w;
+        outZ[i] = m[2] * x + m[6] * y + m[10] * z + m[14] * w;
+    }
+}
+
+/*
+AoS: упакованные тройки x, y, z (stride 12 байт).
+SSE-ветка читает 4 вершины тремя загрузками, перекладывает их в SoA
+перестановками, считает как transformSoA и собирает обратно.
+in и out могут совпадать.
+*/
+inline void transformAoS(const float* m, float w, const float* in, float* out, size_t count) {
+    size_t i = 0;
+
+#ifdef MATRIX_SIMD_SSE
+    {
+        using namespace detail;
+        __m128 m0 = _mm_set1_ps(m[0]), m1 = _mm_set1_ps(m[1]), m2 = _mm_set1_ps(m[2]);
+        __m128 m4 = _mm_set1_ps(m[4]), m5 = _mm_set1_ps(m[5]), m6 = _mm_set1_ps(m[6]);
+        __m128 m8 = _mm_set1_ps(m[8]), m9 = _mm_set1_ps(m[9]), m10 = _mm_set1_ps(m[10]);
+        __m128 tx = _mm_set1_ps(m[12] * w), ty = _mm_set1_ps(m[13] * w), tz = _mm_set1_ps(m[14] * w);
+
+        for (; i + 4 <= count; i += 4) {
+            // v0 = x0 y0 z0 x1, v1 = y1 z1 x2 y2, v2 = z2 x3 y3 z3
+            __m128 v0 = _mm_loadu_ps(in + i * 3);
+            __m128 v1 = _mm_loadu_ps(in + i * 3 + 4);
+            __m128 v2 = _mm_loadu_ps(in + i * 3 + 8);
+
+            __m128 x = MATRIX_SIMD_SHUFFLE(MATRIX_SIMD_SWIZZLE(v0, 0, 3, 3, 3),
+                MATRIX_SIMD_SHUFFLE(v1, v2, 2, 2, 1, 1), 0, 1, 0, 2);
+            __m128 y = MATRIX_SIMD_SHUFFLE(MATRIX_SIMD_SHUFFLE(v0, v1, 1, 1, 0, 0),
+                MATRIX_SIMD_SHUFFLE(v1, v2, 3, 3, 2, 2), 0, 2, 0, 2);
+            __m128 z = MATRIX_SIMD_SHUFFLE(MATRIX_SIMD_SHUFFLE(v0, v1, 2, 2, 1, 1),
+                MATRIX_SIMD_SWIZZLE(v2, 0, 0, 3, 3), 0, 2, 0, 2);
+
+            __m128 rx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m0, x), _mm_mul_ps(m4, y)),
+                _mm_add_ps(_mm_mul_ps(m8, z), tx));
+            __m128 ry = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m1, x), _mm_mul_ps(m5, y)),
+                _mm_add_ps(_mm_mul_ps(m9, z), ty));
+            __m128 rz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m2, x), _mm_mul_ps(m6, y)),
+                _mm_add_ps(_mm_mul_ps(m10, z), tz));
+
+            // Обратно в x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3
+            __m128 o0 = MATRIX_SIMD_SHUFFLE(MATRIX_SIMD_SHUFFLE(rx, ry, 0, 1, 0, 0),
+                MATRIX_SIMD_SHUFFLE(rz, rx, 0, 0, 1, 1), 0, 2, 0, 2);
+            __m128 o1 = MATRIX_SIMD_SHUFFLE(MATRIX_SIMD_SHUFFLE(ry, rz, 1, 1, 1, 1),
+                MATRIX_SIMD_SHUFFLE(rx, ry, 2, 2, 2, 2), 0, 2, 0, 2);
+            __m128 o2 = MATRIX_SIMD_SHUFFLE(MATRIX_SIMD_SHUFFLE(rz, rx, 2, 2, 3, 3),
+                MATRIX_SIMD_SHUFFLE(ry, rz, 3, 3, 3, 3), 0, 2, 0, 2);
+
+            _mm_storeu_ps(out + i * 3, o0);
+            _mm_storeu_ps(out + i * 3 + 4, o1);
+            _mm_storeu_ps(out + i * 3 + 8, o2);
+        }
+    }
+#endif
+
+    for (; i < count; i++) {
+        float x = in[i * 3], y = in[i * 3 + 1], z = in[i * 3 + 2];
+        out[i * 3] = m[0] * x + m[4] * y + m[8] * z + m[12] * w;
+        out[i * 3 + 1] = m[1] * x + m[5] * y + m[9] * z + m[13] * w;
+        out[i * 3 + 2] = m[2] * x + m[6] * y + m[10] * z + m[14] * w;
+    }
+}
+
+// Удобные обёртки
+inline void transformPositionsSoA(const float* m, const float* inX, const float* inY, const float* inZ,
+    float* outX, float* outY, float* outZ, size_t count) {
+    transformSoA(m, 1.0f, inX, inY, inZ, outX, outY, outZ, count);
+}
+
+inline void transformNormalsSoA(const float* m, const float* inX, const float* inY, const float* inZ,
+    float* outX, float* outY, float* outZ, size_t count) {
+    transformSoA(m, 0.0f, inX, inY, inZ, outX, outY, outZ, count);
+}
+
+inline void transformPositionsAoS(const float* m, const float* in, float* out, size_t count) {
+    transformAoS(m, 1.0f, in, out, count);
+}
+
+inline void transformNormalsAoS(const float* m, const float* in, float* out, size_t count) {
+    transformAoS(m, 0.0f, in, out, count);
+}
+
+}  // namespace MatrixSIMD
+
+// Вспомогательные макросы перестановок нужны только внутри заголовка
+#undef MATRIX_SIMD_SWIZZLE
+#undef MATRIX_SIMD_SHUFFLE
@@ -0,0 +1,94 @@
+#pragma once
+#include <GL/glew.h>
+#include <utility>
+
+// ============================================
+// Владеющие дескрипторы объектов OpenGL
+// ============================================
+
+// unsigned int для VAO/VBO копируется молча, и два владельца удаляют один объект.
+// UniqueHandle только перемещается: после std::move исходный дескриптор пуст (0),
+// его деструктор ничего не удаляет. Объект удаляется ровно один раз.
+//   GLHandle::Buffer VBO = GLHandle::Buffer::generate();
+//   glBindBuffer(GL_ARRAY_BUFFER, VBO.get());
+// Функции GL - указатели GLEW, поэтому создание и удаление заданы через классы-свойства.
+
+namespace GLHandle {
+
+struct BufferTraits {
+    static unsigned int generate() { unsigned int id; glGenBuffers(1, &id); return id; }
+    static void destroy(unsigned int id) { glDeleteBuffers(1, &id); }
+};
+
+struct VertexArrayTraits {
+    static unsigned int generate() { unsigned int id; glGenVertexArrays(1, &id); return id; }
+    static void destroy(unsigned int id) { glDeleteVertexArrays(1, &id); }
+};
+
+struct TextureTraits {
+    static unsigned int generate() { unsigned int id; glGenTextures(1, &id); return id; }
+    static void destroy(unsigned int id) { glDeleteTextures(1, &id); }
+};
+
+struct QueryTraits {
+    static unsigned int generate() { unsigned int id; glGenQueries(1, &id); return id; }
+    static void destroy(unsigned int id) { glDeleteQueries(1, &id); }
+};
+
+// Программа создаётся компоновкой шейдеров, поэтому generate() нет -
+// дескриптор принимает готовый id: GLHandle::Program program(createShaderProgram());
+struct ProgramTraits {
+    static void destroy(unsigned int id) { glDeleteProgram(id); }
+};
+
+template <typename Traits>
+class UniqueHandle {
+private:
+    unsigned int id;
+
+public:
+    UniqueHandle() : id(0) {}
+    explicit UniqueHandle(unsigned int id) : id(id) {}
+
+    static UniqueHandle generate() { return UniqueHandle(Traits::generate()); }
+
+    ~UniqueHandle() { reset(); }
+
+    UniqueHandle(const UniqueHandle&) = delete;
+    UniqueHandle& operator=(const UniqueHandle&) = delete;
+
+    UniqueHandle(UniqueHandle&& other) noexcept : id(other.id) { other.id = 0; }
+
+    UniqueHandle& operator=(UniqueHandle&& other) noexcept {
+        if (this != &other) {
+            reset();
+            id = other.id;
+            other.id = 0;
+        }
+        return *this;
+    }
+
+    unsigned int get() const { return id; }
+    explicit operator bool() const { return id != 0; }
+
+    // Удалить текущий объект и (необязательно) взять во владение другой
+    void reset(unsigned int newId = 0) {
+        if (id) Traits::destroy(id);
+        id = newId;
+    }
+
+    // Отдать объект без удаления
+    unsigned int release() {
+        unsigned int result = id;
+        id = 0;
+        return result;
+    }
+};
+
+typedef UniqueHandle<BufferTraits> Buffer;
+typedef UniqueHandle<VertexArrayTraits> VertexArray;
+typedef UniqueHandle<TextureTraits> Texture;
+typedef UniqueHandle<QueryTraits> Query;
+typedef UniqueHandle<ProgramTraits> Program;
+
+}  // namespace GLHandle
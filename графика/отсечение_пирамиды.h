@@ -0,0 +1,247 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include <thread>
+#include <algorithm>
+
+// ============================================
+// Отсечение ограничивающих сфер по пирамиде видимости (SSE/AVX/AVX-512)
+// ============================================
+
+// Сферы хранятся SoA-массивами (x[], y[], z[], r[]) - так за одну инструкцию
+// проверяется сразу 4 (SSE), 8 (AVX) или 16 (AVX-512) сфер против одной плоскости.
+// Результат - плотный список индексов видимых сфер (для инстансинга).
+// С FRUSTUM_CULL_SCALAR всегда используется обычный C++.
+
+#if !defined(FRUSTUM_CULL_SCALAR) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define FRUSTUM_CULL_SSE 1
+#include <xmmintrin.h>
+#if defined(__AVX__)
+#define FRUSTUM_CULL_AVX 1
+#include <immintrin.h>
+#endif
+#if defined(__AVX512F__)
+#define FRUSTUM_CULL_AVX512 1
+#endif
+#endif
+
+namespace FrustumCulling {
+
+// Шесть плоскостей (a, b, c, d): точка p внутри, если a*x + b*y + c*z + d >= 0
+struct Frustum {
+    float planes[6][4];
+};
+
+/*
+Извлечение плоскостей из матрицы projection * view (метод Gribb-Hartmann):
+1. В пространстве отсечения точка видима, если -w <= x, y, z <= w
+2. x_clip = row0 * p, w_clip = row3 * p, поэтому левая плоскость = row3 + row0,
+   правая = row3 - row0, и так же для y (низ/верх) и z (ближняя/дальняя)
+3. Нормируем (a, b, c), чтобы a*x + b*y + c*z + d было расстоянием -
+   тогда сфера сравнивается просто с -r
+Матрица хранится по столбцам: m[col * 4 + row].
+*/
+inline Frustum extractFrustum(const float* m) {
+    Frustum f;
+    for (int i = 0; i < 3; i++) {
+        for (int side = 0; side < 2; side++) {
+            float sign = side == 0 ? 1.0f : -1.0f;
+            float* p = f.planes[i * 2 + side];
+            for (int col = 0; col < 4; col++) {
+                p[col] = m[col * 4 + 3] + sign * m[col * 4 + i];
+            }
+            float length = std::sqrt(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+            if (length > 0.0f) {
+                for (int k = 0; k < 4; k++) p[k] /= length;
+            }
+        }
+    }
+    return f;
+}
+
+// Набор ограничивающих сфер в раскладке SoA
+struct BoundingSpheres {
+    std::vector<float> x, y, z, r;
+
+    void resize(size_t count) {
+        x.resize(count);
+        y.resize(count);
+        z.resize(count);
+        r.resize(count);
+    }
+
+    size_t size() const { return x.size(); }
+
+    void set(size_t i, float cx, float cy, float cz, float radius) {
+        x[i] = cx;
+        y[i] = cy;
+        z[i] = cz;
+        r[i] = radius;
+    }
+};
+
+inline bool isSphereVisible(const Frustum& f, float x, float y, float z, float r) {
+    for (int p = 0; p < 6; p++) {
+        const float* pl = f.planes[p];
+        if (pl[0] * x + pl[1] * y + pl[2] * z + pl[3] < -r) return false;
+    }
+    return true;
+}
+
+// Дописать индексы из битовой маски видимости (бит k - сфера base + k)
+inline size_t appendMask(uint32_t mask, uint32_t base, uint32_t* out) {
+    size_t count = 0;
+    while (mask) {
+#if defined(__GNUC__) || defined(__clang__)
+        int bit = __builtin_ctz(mask);
+#else
+        int bit = 0;
+        while (!(mask & (1u << bit))) bit++;
+#endif
+        out[count++] = base + (uint32_t)bit;
+        mask &= mask - 1;
+    }
+    return count;
+}
+
+// Проверка сфер [begin, end). Индексы видимых пишутся в out подряд, возвращается их число.
+// out должен вмещать end - begin элементов.
+inline size_t cullRange(const Frustum& f, const float* xs, const float* ys, const float* zs,
+    const float* rs, size_t begin, size_t end, uint32_t* out) {
+    size_t count = 0;
+    size_t i = begin;
+
+#if defined(FRUSTUM_CULL_AVX512)
+    __m512 pa[6], pb[6], pc[6], pd[6];
+    for (int p = 0; p < 6; p++) {
+        pa[p] = _mm512_set1_ps(f.planes[p][0]);
+        pb[p] = _mm512_set1_ps(f.planes[p][1]);
+        pc[p] = _mm512_set1_ps(f.planes[p][2]);
+        pd[p] = _mm512_set1_ps(f.planes[p][3]);
+    }
+    for (; i + 16 <= end; i += 16) {
+        __m512 x = _mm512_loadu_ps(xs + i);
+        __m512 y = _mm512_loadu_ps(ys + i);
+        __m512 z = _mm512_loadu_ps(zs + i);
+        __m512 negR = _mm512_sub_ps(_mm512_setzero_ps(), _mm512_loadu_ps(rs + i));
+        __mmask16 inside = 0xFFFF;
+        for (int p = 0; p < 6; p++) {
+            __m512 dist = _mm512_fmadd_ps(pa[p], x,
+                _mm512_fmadd_ps(pb[p], y, _mm512_fmadd_ps(pc[p], z, pd[p])));
+            inside = _mm512_mask_cmp_ps_mask(inside, dist, negR, _CMP_GE_OQ);
+        }
+        count += appendMask((uint32_t)inside, (uint32_t)i, out + count);
+    }
+#elif defined(FRUSTUM_CULL_AVX)
+    __m256 pa[6], pb[6], pc[6], pd[6];
+    for (int p = 0; p < 6; p++) {
+        pa[p] = _mm256_set1_ps(f.planes[p][0]);
+        pb[p] = _mm256_set1_ps(f.planes[p][1]);
+        pc[p] = _mm256_set1_ps(f.planes[p][2]);
+        pd[p] = _mm256_set1_ps(f.planes[p][3]);
+    }
+    for (; i + 8 <= end; i += 8) {
+        __m256 x = _mm256_loadu_ps(xs + i);
+        __m256 y = _mm256_loadu_ps(ys + i);
+        __m256 z = _mm256_loadu_ps(zs + i);
+        __m256 negR = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(rs + i));
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int p = 0; p < 6; p++) {
+            __m256 dist = _mm256_add_ps(
+                _mm256_add_ps(_mm256_mul_ps(pa[p], x), _mm256_mul_ps(pb[p], y)),
+                _mm256_add_ps(_mm256_mul_ps(pc[p], z), pd[p]));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(dist, negR, _CMP_GE_OQ));
+        }
+        count += appendMask((uint32_t)_mm256_movemask_ps(inside), (uint32_t)i, out + count);
+    }
+#elif defined(FRUSTUM_CULL_SSE)
+    __m128 pa[6], pb[6], pc[6], pd[6];
+    for (int p = 0; p < 6; p++) {
+        pa[p] = _mm_set1_ps(f.planes[p][0]);
+        pb[p] = _mm_set1_ps(f.planes[p][1]);
+        pc[p] = _mm_set1_ps(f.planes[p][2]);
+        pd[p] = _mm_set1_ps(f.planes[p][3]);
+    }
+    for (; i + 4 <= end; i += 4) {
+        __m128 x = _mm_loadu_ps(xs + i);
+        __m128 y = _mm_loadu_ps(ys + i);
+        __m128 z = _mm_loadu_ps(zs + i);
+        __m128 negR = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(rs + i));
+        __m128 inside = _mm_cmpeq_ps(x, x);  // все единицы (кроме NaN)
+        for (int p = 0; p < 6; p++) {
+            __m128 dist = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(pa[p], x), _mm_mul_ps(pb[p], y)),
+                _mm_add_ps(_mm_mul_ps(pc[p], z), pd[p]));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(dist, negR));
+        }
+        count += appendMask((uint32_t)_mm_movemask_ps(inside), (uint32_t)i, out + count);
+    }
+#endif
+
+    // Хвост (и скалярная ветка целиком)
+    for (; i < end; i++) {
+        if (isSphereVisible(f, xs[i], ys[i], zs[i], rs[i])) {
+            out[count++] = (uint32_t)i;
+        }
+    }
+    return count;
+}
+
+/*
+Многопоточное отсечение:
+1. Массив делится на равные куски, по одному на поток
+2. Каждый поток пишет индексы видимых сфер в свой участок visible, начиная с begin
+   (участок всегда достаточно велик - видимых не больше, чем сфер в куске)
+3. После join участки сдвигаются влево друг за другом - порядок индексов сохраняется
+Для небольших наборов потоки не создаются.
+*/
+inline size_t cullSpheres(const Frustum& f, const BoundingSpheres& spheres,
+    std::vector<uint32_t>& visible, unsigned int threadCount = 0) {
+    size_t n = spheres.size();
+    visible.resize(n);
+    if (n == 0) return 0;
+
+    if (threadCount == 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+    // Меньше 16K сфер на поток - накладные расходы на запуск потоков больше выигрыша
+    threadCount = (unsigned int)std::min<size_t>(threadCount, n / 16384 + 1);
+
+    const float* xs = spheres.x.data();
+    const float* ys = spheres.y.data();
+    const float* zs = spheres.z.data();
+    const float* rs = spheres.r.data();
+
+    if (threadCount == 1) {
+        size_t count = cullRange(f, xs, ys, zs, rs, 0, n, visible.data());
+        visible.resize(count);
+        return count;
+    }
+
+    std::vector<size_t> counts(threadCount, 0);
+    std::vector<std::thread> threads;
+    size_t chunk = (n + threadCount - 1) / threadCount;
+    chunk = (chunk + 15) & ~(size_t)15;  // кратно ширине самого широкого регистра
+    for (unsigned int t = 0; t < threadCount; t++) {
+        size_t begin = std::min(n, t * chunk);
+        size_t end = std::min(n, begin + chunk);
+        threads.emplace_back([&, t, begin, end]() {
+            counts[t] = cullRange(f, xs, ys, zs, rs, begin, end, visible.data() + begin);
+        });
+    }
+    for (std::thread& th : threads) th.join();
+
+    size_t total = 0;
+    for (unsigned int t = 0; t < threadCount; t++) {
+        size_t begin = std::min(n, t * chunk);
+        if (begin != total && counts[t] > 0) {
+            std::memmove(visible.data() + total, visible.data() + begin, counts[t] * sizeof(uint32_t));
+        }
+        total += counts[t];
+    }
+    visible.resize(total);
+    return total;
+}
+
+}  // namespace FrustumCulling
@@ -0,0 +1,227 @@
+#pragma once
+#include <GL/glew.h>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+
+// ============================================
+// Очередь команд отрисовки с сортировкой по состоянию
+// ============================================
+
+// Вместо рисования в порядке кода команды складываются в очередь и в конце кадра
+// сортируются по 64-битному ключу: слой, программа, VAO, текстура, глубина.
+// Команды с одинаковым состоянием оказываются рядом, а кэш состояния пропускает
+// повторные glUseProgram / glBindVertexArray / glBindTexture / glEnable(GL_BLEND).
+
+namespace RenderQueue {
+
+struct DrawCommand {
+    unsigned int program = 0;
+    unsigned int vertexArray = 0;
+    unsigned int texture = 0;        // GL_TEXTURE_2D на блоке 0
+    bool blend = false;              // glBlendFunc задаётся заранее, здесь только вкл/выкл
+    int mode = GL_TRIANGLES;
+    int first = 0;                   // первая вершина или первый индекс
+    int count = 0;                   // 0 - команда рисует сама в callback
+    int instanceCount = 0;           // 0 - без инстансинга
+    bool indexed = false;            // glDrawElements с GL_UNSIGNED_INT
+    // Вызывается после установки состояния и перед отрисовкой: uniform-переменные,
+    // постоянные атрибуты или собственное рисование (count = 0)
+    void (*callback)(const DrawCommand&) = nullptr;
+    const void* userData = nullptr;
+};
+
+/*
+Ключ сортировки (старшие биты важнее):
+  63..56  слой        - порядок наложения (фон, фигуры, полупрозрачное ...)
+  55..46  программа   - смена программы самая дорогая
+  45..32  VAO
+  31..20  текстура
+  19..0   глубина     - [0, 1], 0 рисуется первым (для непрозрачных - спереди назад)
+Имена объектов GL обрезаются до ширины поля: совпадение младших битов у разных
+объектов портит только группировку, но не правильность.
+*/
+inline uint64_t makeKey(uint8_t layer, unsigned int program, unsigned int vertexArray,
+    unsigned int texture, float depth) {
+    uint64_t quantizedDepth = (uint64_t)(std::min(std::max(depth, 0.0f), 1.0f) * 0xFFFFF);
+    return ((uint64_t)layer << 56) |
+        ((uint64_t)(program & 0x3FF) << 46) |
+        ((uint64_t)(vertexArray & 0x3FFF) << 32) |
+        ((uint64_t)(texture & 0xFFF) << 20) |
+        quantizedDepth;
+}
+
+struct SortEntry {
+    uint64_t key;
+    uint32_t index;
+};
+
+/*
+Поразрядная сортировка (LSD, по байту за проход):
+1. Гистограммы всех 8 байт ключа собираются за один проход по массиву
+2. Проход по байту, у которого все ключи совпадают, пропускается - обычно
+   слой, программа и VAO принимают лишь несколько значений
+3. Сортировка устойчивая: команды с равными ключами остаются в порядке добавления
+   (важно для полупрозрачных фигур в одном слое)
+*/
+inline void radixSort(std::vector<SortEntry>& entries, std::vector<SortEntry>& scratch) {
+    size_t n = entries.size();
+    if (n < 2) return;
+    scratch.resize(n);
+
+    uint32_t counts[8][256];
+    std::memset(counts, 0, sizeof(counts));
+    for (const SortEntry& e : entries) {
+        for (int b = 0; b < 8; b++) counts[b][(e.key >> (b * 8)) & 0xFF]++;
+    }
+
+    SortEntry* src = entries.data();
+    SortEntry* dst = scratch.data();
+    for (int b = 0; b < 8; b++) {
+        uint32_t* count = counts[b];
+        if (count[(src[0].key >> (b * 8)) & 0xFF] == n) continue;
+
+        uint32_t offset = 0;
+        for (int i = 0; i < 256; i++) {
+            uint32_t c = count[i];
+            count[i] = offset;
+            offset += c;
+        }
+        for (size_t i = 0; i < n; i++) {
+            dst[count[(src[i].key >> (b * 8)) & 0xFF]++] = src[i];
+        }
+        std::swap(src, dst);
+    }
+    if (src != entries.data()) std::memcpy(entries.data(), src, n * sizeof(SortEntry));
+}
+
+// Запоминает текущее состояние GL и не повторяет уже сделанные вызовы
+class StateCache {
+private:
+    static const unsigned int UNKNOWN = 0xFFFFFFFFu;
+    unsigned int program, vertexArray, texture;
+    int blend;  // -1 - неизвестно
+
+public:
+    struct Stats {
+        uint32_t programChanges, vertexArrayChanges, textureChanges, blendChanges, skipped;
+    };
+    Stats stats;
+
+    StateCache() { invalidate(); resetStats(); }
+
+    // Состояние могли поменять в обход кэша - следующий вызов выполнится в любом случае
+    void invalidate() {
+        program = vertexArray = texture = UNKNOWN;
+        blend = -1;
+    }
+
+    void forgetBindings() {
+        vertexArray = texture = UNKNOWN;
+    }
+
+    void resetStats() { stats = Stats{ 0, 0, 0, 0, 0 }; }
+
+    void useProgram(unsigned int id) {
+        if (id == program) { stats.skipped++; return; }
+        glUseProgram(id);
+        program = id;
+        stats.programChanges++;
+    }
+
+    void bindVertexArray(unsigned int id) {
+        if (id == vertexArray) { stats.skipped++; return; }
+        glBindVertexArray(id);
+        vertexArray = id;
+        stats.vertexArrayChanges++;
+    }
+
+    void bindTexture(unsigned int id) {
+        if (id == texture) { stats.skipped++; return; }
+        glBindTexture(GL_TEXTURE_2D, id);
+        texture = id;
+        stats.textureChanges++;
+    }
+
+    void setBlend(bool enabled) {
+        if ((int)enabled == blend) { stats.skipped++; return; }
+        if (enabled) glEnable(GL_BLEND);
+        else glDisable(GL_BLEND);
+        blend = enabled;
+        stats.blendChanges++;
+    }
+};
+
+class Queue {
+private:
+    std::vector<DrawCommand> commands;
+    std::vector<SortEntry> entries, scratch;
+    StateCache cache;
+    StateCache::Stats lastStats;
+    size_t lastCommandCount;
+
+public:
+    Queue() : lastStats(StateCache::Stats{ 0, 0, 0, 0, 0 }), lastCommandCount(0) {}
+
+    void submit(const DrawCommand& command, uint8_t layer, float depth = 0.0f) {
+        entries.push_back({ makeKey(layer, command.program, command.vertexArray, command.texture, depth),
+            (uint32_t)commands.size() });
+        commands.push_back(command);
+    }
+
+    /*
+    Выполнение очереди:
+    1. Кэш сбрасывается - между кадрами состояние меняли в обход очереди
+    2. Сортировка ключей, затем команды по порядку: состояние через кэш, callback, отрисовка
+    3. Команда, рисующая сама (count = 0), могла привязать что угодно - после неё
+       кэш забывает VAO и текстуру (программа и смешивание - на совести callback)
+    4. В конце VAO 0 - остальной код кадра рассчитывает на отвязанный VAO
+    */
+    void flush() {
+        cache.invalidate();
+        cache.resetStats();
+        radixSort(entries, scratch);
+
+        for (const SortEntry& entry : entries) {
+            const DrawCommand& c = commands[entry.index];
+            cache.useProgram(c.program);
+            cache.bindVertexArray(c.vertexArray);
+            cache.bindTexture(c.texture);
+            cache.setBlend(c.blend);
+            if (c.callback) c.callback(c);
+
+            if (c.count == 0) {
+                cache.forgetBindings();
+            }
+            else if (c.indexed) {
+                const void* offset = (const void*)(uintptr_t)(c.first * sizeof(uint32_t));
+                if (c.instanceCount > 0) {
+                    glDrawElementsInstanced(c.mode, c.count, GL_UNSIGNED_INT, offset, c.instanceCount);
+                }
+                else {
+                    glDrawElements(c.mode, c.count, GL_UNSIGNED_INT, offset);
+                }
+            }
+            else if (c.instanceCount > 0) {
+                glDrawArraysInstanced(c.mode, c.first, c.count, c.instanceCount);
+            }
+            else {
+                glDrawArrays(c.mode, c.first, c.count);
+            }
+        }
+        glBindVertexArray(0);
+
+        lastStats = cache.stats;
+        lastCommandCount = commands.size();
+        commands.clear();
+        entries.clear();
+    }
+
+    // Статистика последнего flush()
+    const StateCache::Stats& getStats() const { return lastStats; }
+    size_t getCommandCount() const { return lastCommandCount; }
+};
+
+}  // namespace RenderQueue
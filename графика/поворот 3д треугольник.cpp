@@ -2,9 +2,15 @@
 #include <GLFW/glfw3.h>
 #include <iostream>
 #include <cmath>
+#include <vector>
+#include <cstddef>
+#include <string>
+#include <unordered_map>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include "упаковка_вершин.h"
+#include "безоконный_режим.h"
 
 // Вершинный шейдер
 const char* vertexShaderSource = R"(
@@ -14,9 +20,14 @@ layout (location = 1) in vec3 aColor;
 
 out vec3 ourColor;
 
+// Общий блок камеры (один буфер на все программы)
+layout (std140) uniform Camera
+{
+    mat4 view;
+    mat4 projection;
+};
+
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
 
 void main()
 {
@@ -37,10 +48,49 @@ void main()
 }
 )";
 
+// Данные блока Camera в раскладке std140
+struct CameraBlock {
+    glm::mat4 view;
+    glm::mat4 projection;
+};
+
+// Uniform-буфер камеры: общий для всех программ, обновляется один раз за кадр
+class CameraUniformBuffer {
+private:
+    unsigned int UBO;
+
+public:
+    // Точка привязки, к которой Shader подключает блок Camera
+    static const unsigned int BINDING = 0;
+
+    CameraUniformBuffer() {
+        glGenBuffers(1, &UBO);
+        glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(CameraBlock), NULL, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        glBindBufferBase(GL_UNIFORM_BUFFER, BINDING, UBO);
+    }
+
+    ~CameraUniformBuffer() {
+        glDeleteBuffers(1, &UBO);
+    }
+
+    void update(const CameraBlock& block) {
+        glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(CameraBlock), &block);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+};
+
+// Типизированный дескриптор uniform-переменной mat4 (location из кэша шейдера)
+struct UniformMat4 { int location = -1; };
+
 // Класс для работы с шейдерами
 class Shader {
 private:
     unsigned int ID;
+    // Имя -> location, заполняется один раз после линковки
+    std::unordered_map<std::string, int> locations;
 
 public:
     Shader(const char* vertexSource, const char* fragmentSource) {
@@ -66,17 +116,54 @@ public:
         // Удаление шейдеров
         glDeleteShader(vertexShader);
         glDeleteShader(fragmentShader);
+
+        cacheUniforms();
     }
 
     void use() {
         glUseProgram(ID);
     }
 
-    void setMat4(const std::string& name, const glm::mat4& mat) const {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+    // Поиск дескриптора (делается один раз, вне цикла рендеринга)
+    UniformMat4 getMat4(const char* name) const {
+        auto it = locations.find(name);
+        return { it != locations.end() ? it->second : -1 };
+    }
+
+    void set(UniformMat4 uniform, const glm::mat4& mat) const {
+        glUniformMatrix4fv(uniform.location, 1, GL_FALSE, &mat[0][0]);
+    }
+
+    // Установка по имени (через кэш, без glGetUniformLocation)
+    void setMat4(const char* name, const glm::mat4& mat) const {
+        set(getMat4(name), mat);
     }
 
 private:
+    // Перебор активных uniform-переменных и привязка блока Camera
+    void cacheUniforms() {
+        int count = 0;
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+
+        char name[256];
+        for (int i = 0; i < count; i++) {
+            int length = 0, size = 0;
+            GLenum type;
+            glGetActiveUniform(ID, i, sizeof(name), &length, &size, &type, name);
+
+            // Переменные блоков не имеют location
+            int location = glGetUniformLocation(ID, name);
+            if (location >= 0) {
+                locations[std::string(name, length)] = location;
+            }
+        }
+
+        unsigned int blockIndex = glGetUniformBlockIndex(ID, "Camera");
+        if (blockIndex != GL_INVALID_INDEX) {
+            glUniformBlockBinding(ID, blockIndex, CameraUniformBuffer::BINDING);
+        }
+    }
+
     void checkCompileErrors(unsigned int shader, std::string type) {
         int success;
         char infoLog[1024];
@@ -118,40 +205,72 @@ unsigned int indices[] = {
     2, 0, 3   // Задняя грань
 };
 
+// Упакованная вершина (12 байт вместо 24):
+// позиция - 4 x half float (w не используется), цвет - 4 x unorm8
+struct PackedVertex {
+    uint16_t position[4];
+    uint8_t color[4];
+};
+
+// Упаковка массива vertices (6 float на вершину) в PackedVertex
+std::vector<PackedVertex> packVertices(const float* source, int vertexCount) {
+    std::vector<PackedVertex> packed(vertexCount);
+    for (int i = 0; i < vertexCount; i++) {
+        const float* v = source + i * 6;
+        for (int k = 0; k < 3; k++) {
+            packed[i].position[k] = VertexPacking::floatToHalf(v[k]);
+            packed[i].color[k] = VertexPacking::toUnorm8(v[3 + k]);
+        }
+        packed[i].position[3] = VertexPacking::floatToHalf(1.0f);
+        packed[i].color[3] = 255;
+    }
+    return packed;
+}
+
 // Обработчик ошибок GLFW
 void error_callback(int error, const char* description) {
     std::cerr << "GLFW Error: " << description << std::endl;
 }
 
-int main() {
-    // Установка обработчика ошибок GLFW
-    glfwSetErrorCallback(error_callback);
+int main(int argc, char** argv) {
+    // --headless: без окна, рисование во внеэкранный буфер заданное число кадров
+    Headless::Options headless = Headless::parseArgs(argc, argv, 800, 600);
+    Headless::Context offscreen;
+    GLFWwindow* window = nullptr;
 
-    // Инициализация GLFW
-    if (!glfwInit()) {
-        std::cerr << "Failed to initialize GLFW" << std::endl;
-        return -1;
+    if (headless.enabled) {
+        if (!offscreen.create(headless)) return -1;
     }
+    else {
+        // Установка обработчика ошибок GLFW
+        glfwSetErrorCallback(error_callback);
+
+        // Инициализация GLFW
+        if (!glfwInit()) {
+            std::cerr << "Failed to initialize GLFW" << std::endl;
+            return -1;
+        }
 
-    // Настройка GLFW
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-    // Создание окна
-    GLFWwindow* window = glfwCreateWindow(800, 600, "3D Triangle (Tetrahedron)", NULL, NULL);
-    if (!window) {
-        std::cerr << "Failed to create GLFW window" << std::endl;
-        glfwTerminate();
-        return -1;
-    }
+        // Настройка GLFW
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+        // Создание окна
+        window = glfwCreateWindow(800, 600, "3D Triangle (Tetrahedron)", NULL, NULL);
+        if (!window) {
+            std::cerr << "Failed to create GLFW window" << std::endl;
+            glfwTerminate();
+            return -1;
+        }
 
-    glfwMakeContextCurrent(window);
+        glfwMakeContextCurrent(window);
 
-    // Инициализация GLEW
-    if (glewInit() != GLEW_OK) {
-        std::cerr << "Failed to initialize GLEW" << std::endl;
-        return -1;
+        // Инициализация GLEW
+        if (glewInit() != GLEW_OK) {
+            std::cerr << "Failed to initialize GLEW" << std::endl;
+            return -1;
+        }
     }
 
     // Настройка OpenGL
@@ -159,6 +278,11 @@ int main() {
 
     // Создание шейдера
     Shader ourShader(vertexShaderSource, fragmentShaderSource);
+    UniformMat4 modelUniform = ourShader.getMat4("model");
+
+    // Камера - в общем uniform-буфере
+    CameraUniformBuffer cameraBuffer;
+    CameraBlock camera;
 
     // Создание VAO, VBO и EBO
     unsigned int VAO, VBO, EBO;
@@ -169,15 +293,34 @@ int main() {
     // Настройка VAO
     glBindVertexArray(VAO);
 
+#ifdef USE_PACKED_VERTICES
+    // Копируем упакованные вершины в VBO
+    std::vector<PackedVertex> packedVertices = packVertices(vertices, sizeof(vertices) / (6 * sizeof(float)));
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, packedVertices.size() * sizeof(PackedVertex),
+        packedVertices.data(), GL_STATIC_DRAW);
+#else
     // Копируем вершины в VBO
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+#endif
 
     // Копируем индексы в EBO
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
 
     // Настройка атрибутов вершин
+#ifdef USE_PACKED_VERTICES
+    // Атрибут позиции (half float)
+    glVertexAttribPointer(0, 3, GL_HALF_FLOAT, GL_FALSE, sizeof(PackedVertex),
+        (void*)offsetof(PackedVertex, position));
+    glEnableVertexAttribArray(0);
+
+    // Атрибут цвета (unorm8 -> [0, 1])
+    glVertexAttribPointer(1, 3, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(PackedVertex),
+        (void*)offsetof(PackedVertex, color));
+    glEnableVertexAttribArray(1);
+#else
     // Атрибут позиции
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
@@ -185,13 +328,14 @@ int main() {
     // Атрибут цвета
     glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
     glEnableVertexAttribArray(1);
+#endif
 
     // Развязывание
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
 
     // Основной цикл рендеринга
-    while (!glfwWindowShouldClose(window)) {
+    while (headless.enabled ? offscreen.nextFrame() : !glfwWindowShouldClose(window)) {
         // Очистка буферов цвета и глубины
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -205,7 +349,7 @@ int main() {
         glm::mat4 projection = glm::mat4(1.0f);
 
         // Вращение модели
-        float time = glfwGetTime();
+        float time = headless.enabled ? offscreen.getTime() : glfwGetTime();
         model = glm::rotate(model, time * glm::radians(50.0f), glm::vec3(0.5f, 1.0f, 0.0f));
 
         // Видовая матрица (камера отодвинута назад)
@@ -213,21 +357,30 @@ int main() {
 
         // Матрица проекции (перспектива)
         int width, height;
-        glfwGetWindowSize(window, &width, &height);
+        if (headless.enabled) {
+            width = offscreen.getWidth();
+            height = offscreen.getHeight();
+        }
+        else {
+            glfwGetWindowSize(window, &width, &height);
+        }
         projection = glm::perspective(glm::radians(45.0f), (float)width / (float)height, 0.1f, 100.0f);
 
-        // Передача матриц в шейдер
-        ourShader.setMat4("model", model);
-        ourShader.setMat4("view", view);
-        ourShader.setMat4("projection", projection);
+        // Передача матриц: модель - в программу, камера - один раз за кадр в общий буфер
+        ourShader.set(modelUniform, model);
+        camera.view = view;
+        camera.projection = projection;
+        cameraBuffer.update(camera);
 
         // Рендеринг треугольника
         glBindVertexArray(VAO);
         glDrawElements(GL_TRIANGLES, 12, GL_UNSIGNED_INT, 0);
 
         // Обмен буферов и опрос событий
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        if (!headless.enabled) {
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+        }
     }
 
     // Очистка ресурсов
@@ -235,9 +388,14 @@ int main() {
     glDeleteBuffers(1, &VBO);
     glDeleteBuffers(1, &EBO);
 
-    // Завершение GLFW
-    glfwDestroyWindow(window);
-    glfwTerminate();
+    // Завершение GLFW (или вывод итогов безоконного режима)
+    if (headless.enabled) {
+        offscreen.finish();
+    }
+    else {
+        glfwDestroyWindow(window);
+        glfwTerminate();
+    }
 
     return 0;
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 #include <cmath>
+#include "безоконный_режим.h"
 
 const char* vertexShaderSource = R"(
 #version 330 core
@@ -39,22 +40,32 @@ void main()
 }
 )";
 
-int main() {
-    // Инициализация GLFW
-    if (!glfwInit()) return -1;
+int main(int argc, char** argv) {
+    // --headless: без окна, рисование во внеэкранный буфер заданное число кадров
+    Headless::Options headless = Headless::parseArgs(argc, argv, 800, 600, false);
+    Headless::Context offscreen;
+    GLFWwindow* window = nullptr;
 
-    // Создание окна
-    GLFWwindow* window = glfwCreateWindow(800, 600, "Вращающийся треугольник", NULL, NULL);
-    if (!window) {
-        glfwTerminate();
-        return -1;
+    if (headless.enabled) {
+        if (!offscreen.create(headless)) return -1;
     }
-    glfwMakeContextCurrent(window);
-
-    // Инициализация GLEW
-    if (glewInit() != GLEW_OK) {
-        std::cerr << "Failed to initialize GLEW" << std::endl;
-        return -1;
+    else {
+        // Инициализация GLFW
+        if (!glfwInit()) return -1;
+
+        // Создание окна
+        window = glfwCreateWindow(800, 600, "Вращающийся треугольник", NULL, NULL);
+        if (!window) {
+            glfwTerminate();
+            return -1;
+        }
+        glfwMakeContextCurrent(window);
+
+        // Инициализация GLEW
+        if (glewInit() != GLEW_OK) {
+            std::cerr << "Failed to initialize GLEW" << std::endl;
+            return -1;
+        }
     }
 
     // Компиляция шейдеров
@@ -103,25 +114,28 @@ int main() {
     GLint rotationLoc = glGetUniformLocation(shaderProgram, "rotationAngle");
 
     // Основной цикл
-    while (!glfwWindowShouldClose(window)) {
+    while (headless.enabled ? offscreen.nextFrame() : !glfwWindowShouldClose(window)) {
         glClear(GL_COLOR_BUFFER_BIT);
 
         // Передача угла вращения в шейдер
-        float angle = (float)glfwGetTime(); // Время в секундах
+        float angle = (float)(headless.enabled ? offscreen.getTime() : glfwGetTime()); // Время в секундах
         glUniform1f(rotationLoc, angle);
 
         // Отрисовка треугольника
         glDrawArrays(GL_TRIANGLES, 0, 3);
 
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        if (!headless.enabled) {
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+        }
     }
 
     // Очистка
     glDeleteProgram(shaderProgram);
     glDeleteShader(vertexShader);
     glDeleteShader(fragmentShader);
-    glfwTerminate();
+    if (headless.enabled) offscreen.finish();
+    else glfwTerminate();
 
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,327 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <fstream>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <glm/glm.hpp>
+
+// ============================================
+// Поворот спрайтов на CPU: наложение в программный кадр
+// ============================================
+
+// Для серверов без GPU: спрайт переносится в кадр (Image в памяти) произвольной
+// аффинной матрицей - в том числе мировой матрицей узла SceneGraph. Каждая строка
+// кадра обратным отображением переводится в отрезок текселей спрайта: границы отрезка
+// считаются заранее, внутри координаты меняются прибавлением шага в фиксированной
+// точке - ни умножения матрицы, ни проверок границ на пиксель. Выборка билинейная (SSE2 - все 4 канала разом),
+// наложение - "source over" с премультиплицированной альфой. Строки кадра делятся
+// на полосы, полосы - между потоками.
+// Пиксели - RGBA8 в uint32_t (в памяти R, G, B, A), первая строка - верхняя.
+
+#if !defined(SPRITE_ROTATION_SCALAR) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define SPRITE_ROTATION_SSE 1
+#include <emmintrin.h>
+#endif
+
+namespace SpriteRotation {
+
+inline uint32_t packRGBA(int r, int g, int b, int a) {
+    return (uint32_t)r | ((uint32_t)g << 8) | ((uint32_t)b << 16) | ((uint32_t)a << 24);
+}
+
+struct Image {
+    int width;
+    int height;
+    std::vector<uint32_t> pixels;
+
+    Image() : width(0), height(0) {}
+    Image(int width, int height, uint32_t fill = 0) :
+        width(width), height(height), pixels((size_t)width * height, fill) {}
+
+    uint32_t* row(int y) { return &pixels[(size_t)y * width]; }
+    const uint32_t* row(int y) const { return &pixels[(size_t)y * width]; }
+
+    void clear(uint32_t color) { std::fill(pixels.begin(), pixels.end(), color); }
+
+    // P6 PPM без альфы (для проверки результата)
+    bool savePPM(const char* path) const {
+        std::ofstream file(path, std::ios::binary);
+        if (!file) return false;
+        file << "P6\n" << width << " " << height << "\n255\n";
+        std::vector<unsigned char> line((size_t)width * 3);
+        for (int y = 0; y < height; y++) {
+            const uint32_t* src = row(y);
+            for (int x = 0; x < width; x++) {
+                line[x * 3] = (unsigned char)(src[x] & 0xFF);
+                line[x * 3 + 1] = (unsigned char)((src[x] >> 8) & 0xFF);
+                line[x * 3 + 2] = (unsigned char)((src[x] >> 16) & 0xFF);
+            }
+            file.write((const char*)line.data(), line.size());
+        }
+        return (bool)file;
+    }
+};
+
+/*
+Спрайт, подготовленный к наложению:
+1. Цвет умножен на альфу - билинейная выборка не тащит цвет прозрачных текселей
+2. Вокруг - рамка в один прозрачный тексель: у выборки на краю все 4 соседа
+   существуют, а край спрайта получается сглаженным без отдельной ветки
+*/
+class Sprite {
+private:
+    int width, height;
+    int stride;                     // width + 2
+    std::vector<uint32_t> texels;
+
+public:
+    Sprite() : width(0), height(0), stride(0) {}
+
+    // image - обычная (не премультиплицированная) альфа
+    explicit Sprite(const Image& image) : width(image.width), height(image.height), stride(image.width + 2),
+        texels((size_t)(image.width + 2) * (image.height + 2), 0) {
+        for (int y = 0; y < height; y++) {
+            const uint32_t* src = image.row(y);
+            uint32_t* dst = &texels[(size_t)(y + 1) * stride + 1];
+            for (int x = 0; x < width; x++) {
+                uint32_t p = src[x];
+                uint32_t a = p >> 24;
+                uint32_t r = ((p & 0xFF) * a + 127) / 255;
+                uint32_t g = (((p >> 8) & 0xFF) * a + 127) / 255;
+                uint32_t b = (((p >> 16) & 0xFF) * a + 127) / 255;
+                dst[x] = packRGBA(r, g, b, a);
+            }
+        }
+    }
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    int getStride() const { return stride; }
+    // Строка y рамочного изображения (0 - верхняя рамка, height + 1 - нижняя)
+    const uint32_t* paddedRow(int y) const { return &texels[(size_t)y * stride]; }
+};
+
+namespace Detail {
+
+const int FRACTION_BITS = 16;
+const int64_t ONE = int64_t(1) << FRACTION_BITS;
+const int TILE_ROWS = 16;
+
+/*
+Билинейная выборка и наложение одного пикселя. top/bottom - по два соседних
+тексела строк спрайта, wx/wy - веса 0..127 (7 бит: разность каналов * вес
+помещается в int16). Сначала смешиваются строки, затем столбцы; затем
+dst = src + dst * (256 - srcA) / 256. Обе ветки считают одинаково.
+*/
+inline void blendBilinear(uint32_t* dst, const uint32_t* top, const uint32_t* bottom, int wx, int wy) {
+#ifdef SPRITE_ROTATION_SSE
+    const __m128i zero = _mm_setzero_si128();
+    __m128i t = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)top), zero);
+    __m128i b = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)bottom), zero);
+    __m128i column = _mm_add_epi16(t, _mm_srai_epi16(_mm_mullo_epi16(_mm_sub_epi16(b, t), _mm_set1_epi16((short)wy)), 7));
+    __m128i right = _mm_unpackhi_epi64(column, column);
+    __m128i src = _mm_add_epi16(column, _mm_srai_epi16(_mm_mullo_epi16(_mm_sub_epi16(right, column), _mm_set1_epi16((short)wx)), 7));
+
+    __m128i alpha = _mm_shufflelo_epi16(src, _MM_SHUFFLE(3, 3, 3, 3));
+    __m128i d = _mm_unpacklo_epi8(_mm_cvtsi32_si128((int)*dst), zero);
+    d = _mm_srli_epi16(_mm_mullo_epi16(d, _mm_sub_epi16(_mm_set1_epi16(256), alpha)), 8);
+    *dst = (uint32_t)_mm_cvtsi128_si32(_mm_packus_epi16(_mm_add_epi16(src, d), zero));
+#else
+    int src[4];
+    for (int c = 0; c < 4; c++) {
+        int shift = c * 8;
+        int t0 = (top[0] >> shift) & 0xFF, t1 = (top[1] >> shift) & 0xFF;
+        int b0 = (bottom[0] >> shift) & 0xFF, b1 = (bottom[1] >> shift) & 0xFF;
+        int c0 = t0 + (((b0 - t0) * wy) >> 7);
+        int c1 = t1 + (((b1 - t1) * wy) >> 7);
+        src[c] = c0 + (((c1 - c0) * wx) >> 7);
+    }
+    uint32_t d = *dst;
+    int inverse = 256 - src[3];
+    uint32_t result = 0;
+    for (int c = 0; c < 4; c++) {
+        int value = src[c] + (int)((((d >> (c * 8)) & 0xFF) * inverse) >> 8);
+        result |= (uint32_t)std::min(value, 255) << (c * 8);
+    }
+    *dst = result;
+#endif
+}
+
+/*
+Отрезок строки кадра, пиксели которого задевают спрайт:
+1. Центр пикселя (x + 0.5, y + 0.5) обратной матрицей переводится в координаты
+   спрайта и сдвигается на 0.5 к центрам текселей: s(x) = s0 + ds * x
+2. Выборка непрозрачна только при -1 < s < width (и так же по t) - это два
+   линейных неравенства на x, отрезок - пересечение решений
+3. Координаты в фиксированной точке линейны по x, поэтому достаточно проверить
+   концы: если концы внутри рамочного спрайта, то и весь отрезок внутри
+*/
+// Аффинное преобразование в double: u = xx * x + yx * y + tx, v = xy * x + yy * y + ty
+struct Affine {
+    double xx, xy, yx, yy, tx, ty;
+
+    // Из glm::mat3 по столбцам (нижняя строка - 0, 0, 1)
+    static Affine fromMatrix(const glm::mat3& m) {
+        return Affine{ m[0][0], m[0][1], m[1][0], m[1][1], m[2][0], m[2][1] };
+    }
+    double determinant() const { return xx * yy - xy * yx; }
+    Affine inverse() const {
+        double inv = 1.0 / determinant();
+        Affine r;
+        r.xx = yy * inv;   r.xy = -xy * inv;
+        r.yx = -yx * inv;  r.yy = xx * inv;
+        r.tx = -(r.xx * tx + r.yx * ty);
+        r.ty = -(r.xy * tx + r.yy * ty);
+        return r;
+    }
+};
+
+struct Span {
+    int x0, x1;            // [x0, x1)
+    int64_t s, t;          // 16.16 в координатах рамочного спрайта в точке x0
+    int64_t ds, dt;
+};
+
+inline void solveAxis(double start, double step, double limit, double& lo, double& hi) {
+    // -1 < start + step * x < limit
+    if (std::fabs(step) < 1e-12) {
+        if (start <= -1.0 || start >= limit) { lo = 1.0; hi = 0.0; }
+        return;
+    }
+    double a = (-1.0 - start) / step, b = (limit - start) / step;
+    if (a > b) std::swap(a, b);
+    lo = std::max(lo, a);
+    hi = std::min(hi, b);
+}
+
+inline bool findSpan(const Affine& inverse, int y, int minX, int maxX, int width, int height, Span& span) {
+    double cy = y + 0.5;
+    // Координаты спрайта при x = 0 (центр пикселя - 0.5), уже со сдвигом к центрам текселей
+    double s0 = inverse.xx * 0.5 + inverse.yx * cy + inverse.tx - 0.5;
+    double t0 = inverse.xy * 0.5 + inverse.yy * cy + inverse.ty - 0.5;
+    double ds = inverse.xx, dt = inverse.xy;
+
+    double lo = minX, hi = maxX - 1;
+    solveAxis(s0, ds, width, lo, hi);
+    solveAxis(t0, dt, height, lo, hi);
+    if (lo > hi) return false;
+    int x0 = std::max(minX, (int)std::ceil(lo));
+    int x1 = std::min(maxX - 1, (int)std::floor(hi));
+
+    // +1 - рамка спрайта: допустимо 0 <= s < width + 1
+    int64_t stepS = (int64_t)std::llround(ds * ONE), stepT = (int64_t)std::llround(dt * ONE);
+    int64_t startS = (int64_t)std::llround((s0 + ds * x0 + 1.0) * ONE);
+    int64_t startT = (int64_t)std::llround((t0 + dt * x0 + 1.0) * ONE);
+    const int64_t limitS = (int64_t)(width + 1) * ONE, limitT = (int64_t)(height + 1) * ONE;
+    auto inside = [&](int x) {
+        int64_t s = startS + stepS * (x - x0), t = startT + stepT * (x - x0);
+        return s >= 0 && s < limitS && t >= 0 && t < limitT;
+    };
+    // Округление могло вывести крайний пиксель за рамку - он всё равно почти прозрачный
+    while (x0 <= x1 && !inside(x0)) {
+        x0++;
+        startS += stepS;
+        startT += stepT;
+    }
+    while (x1 >= x0 && !inside(x1)) x1--;
+    if (x0 > x1) return false;
+
+    span.x0 = x0;
+    span.x1 = x1 + 1;
+    span.s = startS;
+    span.t = startT;
+    span.ds = stepS;
+    span.dt = stepT;
+    return true;
+}
+
+inline void drawRows(const Sprite& sprite, const Affine& inverse, Image& target,
+    int minX, int maxX, int rowBegin, int rowEnd) {
+    const int stride = sprite.getStride();
+    const uint32_t* base = sprite.paddedRow(0);
+    for (int y = rowBegin; y < rowEnd; y++) {
+        Span span;
+        if (!findSpan(inverse, y, minX, maxX, sprite.getWidth(), sprite.getHeight(), span)) continue;
+        uint32_t* dst = target.row(y);
+        int64_t s = span.s, t = span.t;
+        for (int x = span.x0; x < span.x1; x++, s += span.ds, t += span.dt) {
+            const uint32_t* top = base + (size_t)(t >> FRACTION_BITS) * stride + (size_t)(s >> FRACTION_BITS);
+            int wx = (int)((s >> (FRACTION_BITS - 7)) & 127);
+            int wy = (int)((t >> (FRACTION_BITS - 7)) & 127);
+            blendBilinear(dst + x, top, top + stride, wx, wy);
+        }
+    }
+}
+
+}  // namespace Detail
+
+/*
+Наложение спрайта на кадр. spriteToTarget переводит пиксельные координаты спрайта
+(0..width, 0..height, y вниз) в пиксельные координаты кадра:
+1. Углы спрайта дают ограничивающий прямоугольник, он обрезается по кадру
+2. Строки прямоугольника делятся на полосы по TILE_ROWS, полоса k достаётся потоку
+   k % threads - повёрнутый спрайт в середине шире, чередование выравнивает нагрузку
+3. Мелкие спрайты рисуются в вызывающем потоке - запуск потоков дороже
+*/
+inline void composite(const Sprite& sprite, const glm::mat3& spriteToTarget, Image& target,
+    unsigned int threadCount = 0) {
+    if (sprite.getWidth() == 0 || sprite.getHeight() == 0 || target.width == 0 || target.height == 0) return;
+    Detail::Affine forward = Detail::Affine::fromMatrix(spriteToTarget);
+    if (std::fabs(forward.determinant()) < 1e-12) return;
+    Detail::Affine inverse = forward.inverse();
+
+    double minX = 1e30, minY = 1e30, maxX = -1e30, maxY = -1e30;
+    const double w = sprite.getWidth(), h = sprite.getHeight();
+    const double cornerX[4] = { 0.0, w, w, 0.0 }, cornerY[4] = { 0.0, 0.0, h, h };
+    for (int i = 0; i < 4; i++) {
+        double px = forward.xx * cornerX[i] + forward.yx * cornerY[i] + forward.tx;
+        double py = forward.xy * cornerX[i] + forward.yy * cornerY[i] + forward.ty;
+        minX = std::min(minX, px); maxX = std::max(maxX, px);
+        minY = std::min(minY, py); maxY = std::max(maxY, py);
+    }
+    // +-1 пиксель - сглаженный край
+    int x0 = std::max(0, (int)std::floor(minX) - 1), x1 = std::min(target.width, (int)std::ceil(maxX) + 1);
+    int y0 = std::max(0, (int)std::floor(minY) - 1), y1 = std::min(target.height, (int)std::ceil(maxY) + 1);
+    if (x0 >= x1 || y0 >= y1) return;
+
+    if (threadCount == 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+    size_t area = (size_t)(x1 - x0) * (y1 - y0);
+    int tiles = (y1 - y0 + Detail::TILE_ROWS - 1) / Detail::TILE_ROWS;
+    threadCount = (unsigned int)std::min<size_t>({ (size_t)threadCount, area / 65536 + 1, (size_t)tiles });
+
+    auto work = [&](unsigned int first, unsigned int step) {
+        for (int tile = (int)first; tile < tiles; tile += (int)step) {
+            int rowBegin = y0 + tile * Detail::TILE_ROWS;
+            Detail::drawRows(sprite, inverse, target, x0, x1, rowBegin, std::min(y1, rowBegin + Detail::TILE_ROWS));
+        }
+        };
+
+    if (threadCount == 1) {
+        work(0, 1);
+        return;
+    }
+
+    std::vector<std::thread> threads;
+    for (unsigned int t = 0; t < threadCount; t++) {
+        threads.emplace_back(work, t, threadCount);
+    }
+    for (std::thread& th : threads) th.join();
+}
+
+// Поворот на angle вокруг точки (centerX, centerY) кадра - перенос в начало, поворот
+// и обратный перенос одной матрицей; спрайт до поворота стоит левым верхним углом в (x, y)
+inline void compositeRotated(const Sprite& sprite, Image& target, float x, float y,
+    float angle, float centerX, float centerY, unsigned int threadCount = 0) {
+    float c = std::cos(angle), s = std::sin(angle);
+    glm::mat3 m(1.0f);
+    m[0][0] = c;  m[0][1] = -s;
+    m[1][0] = s;  m[1][1] = c;
+    m[2][0] = centerX + c * (x - centerX) + s * (y - centerY);
+    m[2][1] = centerY - s * (x - centerX) + c * (y - centerY);
+    composite(sprite, m, target, threadCount);
+}
+
+}  // namespace SpriteRotation
@@ -0,0 +1,338 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <vector>
+#include <queue>
+#include <algorithm>
+
+// ============================================
+// Пространственный индекс: "рыхлое" дерево квадрантов
+// ============================================
+
+// Индекс по ограничивающим прямоугольникам фигур: что под курсором (точка),
+// что видно (прямоугольник), что ближе всего (ближайший). Вместо перебора всех
+// фигур обходятся только узлы, чьи границы пересекают запрос.
+// Узлы не создаются динамически: уровень L - это сетка 2^L x 2^L ячеек с головами
+// списков и счётчиками фигур в поддереве (пустые поддеревья пропускаются сразу).
+
+namespace SpatialIndex {
+
+const uint32_t INVALID_ID = 0xFFFFFFFFu;
+
+struct Box {
+    float minX, minY, maxX, maxY;
+};
+
+inline Box boxAround(float x, float y, float halfWidth, float halfHeight) {
+    return Box{ x - halfWidth, y - halfHeight, x + halfWidth, y + halfHeight };
+}
+
+inline bool overlaps(const Box& a, const Box& b) {
+    return a.minX <= b.maxX && b.minX <= a.maxX && a.minY <= b.maxY && b.minY <= a.maxY;
+}
+
+inline bool contains(const Box& outer, const Box& inner) {
+    return outer.minX <= inner.minX && inner.maxX <= outer.maxX &&
+        outer.minY <= inner.minY && inner.maxY <= outer.maxY;
+}
+
+// Квадрат расстояния от точки до прямоугольника (0 - точка внутри)
+inline float distanceSquared(const Box& b, float x, float y) {
+    float dx = std::max(std::max(b.minX - x, 0.0f), x - b.maxX);
+    float dy = std::max(std::max(b.minY - y, 0.0f), y - b.maxY);
+    return dx * dx + dy * dy;
+}
+
+/*
+Рыхлое дерево квадрантов (loose quadtree):
+1. Границы узла расширены на половину ячейки с каждой стороны (вдвое больше обычных)
+2. Фигура кладётся на самый глубокий уровень, где ячейка не меньше фигуры, в ячейку
+   по её центру - тогда фигура гарантированно внутри рыхлых границ узла.
+   Уровень и ячейка считаются формулой, без спуска по дереву: вставка O(глубина)
+3. При движении фигура переносится, только если сменилась ячейка или уровень;
+   мелкие сдвиги - просто запись нового прямоугольника (update / updateBatch)
+4. Запрос: спуск от корня с отсечением узлов по рыхлым границам; если узел целиком
+   внутри запроса, его поддерево выдаётся без проверок
+5. Идентификатор фигуры не совпадает с местом записи в массиве: optimize() переставляет
+   записи в порядке обхода дерева, и фигуры узла (и всего поддерева) лежат подряд -
+   запрос читает память последовательно, а не прыгает по спискам
+Фигуры с центром вне мира лежат в корне - корень всегда проверяется.
+*/
+class LooseQuadtree {
+private:
+    struct Item {
+        Box box;
+        int32_t next, prev;     // список фигур узла (номера записей)
+        int32_t level;          // -1 - запись свободна
+        uint32_t cell;
+        uint32_t id;
+    };
+
+    struct Level {
+        uint32_t size;                  // ячеек по стороне
+        std::vector<int32_t> heads;
+        std::vector<uint32_t> counts;   // фигур в поддереве ячейки
+    };
+
+    float worldMinX, worldMinY, worldWidth, worldHeight;
+    int maxDepth;
+    std::vector<Level> levels;
+    std::vector<Item> items;
+    std::vector<uint32_t> slotOf;       // идентификатор -> запись
+    std::vector<uint32_t> freeIds;
+    std::vector<uint32_t> freeSlots;
+    size_t itemCount;
+
+    void locate(const Box& b, int& level, uint32_t& cell) const {
+        float u = ((b.minX + b.maxX) * 0.5f - worldMinX) / worldWidth;
+        float v = ((b.minY + b.maxY) * 0.5f - worldMinY) / worldHeight;
+        if (!(u >= 0.0f && u < 1.0f && v >= 0.0f && v < 1.0f)) {
+            level = 0;
+            cell = 0;
+            return;
+        }
+        float extent = std::max((b.maxX - b.minX) / worldWidth, (b.maxY - b.minY) / worldHeight);
+        level = maxDepth;
+        if (extent > 0.0f) {
+            level = std::min(maxDepth, std::max(0, (int)std::floor(-std::log2(extent))));
+        }
+        uint32_t n = levels[level].size;
+        uint32_t x = std::min(n - 1, (uint32_t)(u * n));
+        uint32_t y = std::min(n - 1, (uint32_t)(v * n));
+        cell = y * n + x;
+    }
+
+    // Изменить счётчики поддеревьев от ячейки до корня
+    void addToCounts(int level, uint32_t cell, int32_t delta) {
+        uint32_t x = cell % levels[level].size;
+        uint32_t y = cell / levels[level].size;
+        for (int l = level; l >= 0; l--) {
+            levels[l].counts[y * levels[l].size + x] += delta;
+            x >>= 1;
+            y >>= 1;
+        }
+    }
+
+    void link(uint32_t slot) {
+        Item& item = items[slot];
+        int32_t& head = levels[item.level].heads[item.cell];
+        item.prev = -1;
+        item.next = head;
+        if (head >= 0) items[head].prev = (int32_t)slot;
+        head = (int32_t)slot;
+        addToCounts(item.level, item.cell, 1);
+    }
+
+    void unlink(uint32_t slot) {
+        Item& item = items[slot];
+        if (item.prev >= 0) items[item.prev].next = item.next;
+        else levels[item.level].heads[item.cell] = item.next;
+        if (item.next >= 0) items[item.next].prev = item.prev;
+        addToCounts(item.level, item.cell, -1);
+    }
+
+    Box looseBounds(int level, uint32_t x, uint32_t y) const {
+        float cellWidth = worldWidth / levels[level].size;
+        float cellHeight = worldHeight / levels[level].size;
+        float minX = worldMinX + x * cellWidth;
+        float minY = worldMinY + y * cellHeight;
+        return Box{ minX - cellWidth * 0.5f, minY - cellHeight * 0.5f,
+            minX + cellWidth * 1.5f, minY + cellHeight * 1.5f };
+    }
+
+    void collectAll(int level, uint32_t x, uint32_t y, std::vector<uint32_t>& out) const {
+        const Level& lv = levels[level];
+        uint32_t cell = y * lv.size + x;
+        if (lv.counts[cell] == 0) return;
+        for (int32_t slot = lv.heads[cell]; slot >= 0; slot = items[slot].next) out.push_back(items[slot].id);
+        if (level == maxDepth) return;
+        for (uint32_t k = 0; k < 4; k++) collectAll(level + 1, x * 2 + (k & 1), y * 2 + (k >> 1), out);
+    }
+
+    void queryNode(int level, uint32_t x, uint32_t y, const Box& query, std::vector<uint32_t>& out) const {
+        const Level& lv = levels[level];
+        uint32_t cell = y * lv.size + x;
+        if (lv.counts[cell] == 0) return;
+        if (level > 0) {
+            Box loose = looseBounds(level, x, y);
+            if (!overlaps(loose, query)) return;
+            if (contains(query, loose)) {
+                collectAll(level, x, y, out);
+                return;
+            }
+        }
+        for (int32_t slot = lv.heads[cell]; slot >= 0; slot = items[slot].next) {
+            if (overlaps(items[slot].box, query)) out.push_back(items[slot].id);
+        }
+        if (level == maxDepth) return;
+        for (uint32_t k = 0; k < 4; k++) queryNode(level + 1, x * 2 + (k & 1), y * 2 + (k >> 1), query, out);
+    }
+
+    // Записи поддерева - подряд в новом массиве, в том же порядке, что и обход запроса
+    void appendSubtree(int level, uint32_t x, uint32_t y, std::vector<Item>& ordered) {
+        Level& lv = levels[level];
+        uint32_t cell = y * lv.size + x;
+        if (lv.counts[cell] == 0) return;
+        int32_t first = -1;
+        for (int32_t slot = lv.heads[cell]; slot >= 0; slot = items[slot].next) {
+            int32_t newSlot = (int32_t)ordered.size();
+            ordered.push_back(items[slot]);
+            ordered.back().prev = first < 0 ? -1 : newSlot - 1;
+            ordered.back().next = -1;
+            if (first < 0) first = newSlot;
+            else ordered[newSlot - 1].next = newSlot;
+            slotOf[items[slot].id] = (uint32_t)newSlot;
+        }
+        lv.heads[cell] = first;
+        if (level == maxDepth) return;
+        for (uint32_t k = 0; k < 4; k++) appendSubtree(level + 1, x * 2 + (k & 1), y * 2 + (k >> 1), ordered);
+    }
+
+public:
+    // Мир [minX, maxX] x [minY, maxY]; глубина 8 - 256 x 256 ячеек на нижнем уровне,
+    // для 10^6 фигур разумно 10
+    LooseQuadtree(float minX, float minY, float maxX, float maxY, int depth = 8)
+        : worldMinX(minX), worldMinY(minY), worldWidth(maxX - minX), worldHeight(maxY - minY),
+        maxDepth(std::max(0, std::min(depth, 15))), itemCount(0) {
+        levels.resize(maxDepth + 1);
+        for (int l = 0; l <= maxDepth; l++) {
+            levels[l].size = 1u << l;
+            levels[l].heads.assign((size_t)levels[l].size * levels[l].size, -1);
+            levels[l].counts.assign((size_t)levels[l].size * levels[l].size, 0);
+        }
+    }
+
+    void reserve(size_t count) {
+        items.reserve(count);
+        slotOf.reserve(count);
+    }
+
+    size_t size() const { return itemCount; }
+
+    // Возвращает идентификатор: выдаются подряд с 0, освобождённые используются повторно
+    uint32_t insert(const Box& box) {
+        uint32_t id;
+        if (!freeIds.empty()) {
+            id = freeIds.back();
+            freeIds.pop_back();
+        }
+        else {
+            id = (uint32_t)slotOf.size();
+            slotOf.push_back(0);
+        }
+        uint32_t slot;
+        if (!freeSlots.empty()) {
+            slot = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        else {
+            slot = (uint32_t)items.size();
+            items.push_back(Item());
+        }
+        slotOf[id] = slot;
+        Item& item = items[slot];
+        item.box = box;
+        item.id = id;
+        locate(box, item.level, item.cell);
+        link(slot);
+        itemCount++;
+        return id;
+    }
+
+    void remove(uint32_t id) {
+        if (id >= slotOf.size()) return;
+        uint32_t slot = slotOf[id];
+        if (slot >= items.size() || items[slot].level < 0 || items[slot].id != id) return;
+        unlink(slot);
+        items[slot].level = -1;
+        freeSlots.push_back(slot);
+        freeIds.push_back(id);
+        itemCount--;
+    }
+
+    void update(uint32_t id, const Box& box) {
+        uint32_t slot = slotOf[id];
+        Item& item = items[slot];
+        int level;
+        uint32_t cell;
+        locate(box, level, cell);
+        item.box = box;
+        if (level == item.level && cell == item.cell) return;
+        unlink(slot);
+        item.level = level;
+        item.cell = cell;
+        link(slot);
+    }
+
+    void updateBatch(const uint32_t* ids, const Box* boxes, size_t count) {
+        for (size_t i = 0; i < count; i++) update(ids[i], boxes[i]);
+    }
+
+    const Box& getBox(uint32_t id) const { return items[slotOf[id]].box; }
+
+    // Переложить записи в порядке обхода дерева: после массовой вставки или когда
+    // много фигур сменило узел. Идентификаторы не меняются
+    void optimize() {
+        std::vector<Item> ordered;
+        ordered.reserve(itemCount);
+        appendSubtree(0, 0, 0, ordered);
+        items.swap(ordered);
+        freeSlots.clear();
+    }
+
+    // Фигуры, чей прямоугольник пересекает query (out дополняется)
+    void queryRect(const Box& query, std::vector<uint32_t>& out) const {
+        queryNode(0, 0, 0, query, out);
+    }
+
+    // Фигуры, чей прямоугольник содержит точку
+    void queryPoint(float x, float y, std::vector<uint32_t>& out) const {
+        queryNode(0, 0, 0, Box{ x, y, x, y }, out);
+    }
+
+    /*
+    Ближайшая фигура (расстояние до прямоугольника, 0 - точка внутри):
+    1. Очередь с приоритетом по расстоянию до рыхлых границ узлов, начиная с корня
+    2. Из очереди берётся ближайший узел; если он дальше лучшей найденной фигуры - конец
+    3. Фигуры узла уточняют лучшую, непустые дочерние узлы идут в очередь
+    */
+    uint32_t nearest(float x, float y, float maxDistance = INFINITY) const {
+        struct Node {
+            float distance2;
+            int level;
+            uint32_t x, y;
+            bool operator>(const Node& other) const { return distance2 > other.distance2; }
+        };
+        std::priority_queue<Node, std::vector<Node>, std::greater<Node>> queue;
+        queue.push({ 0.0f, 0, 0, 0 });
+
+        uint32_t best = INVALID_ID;
+        float bestDistance2 = maxDistance * maxDistance;
+        while (!queue.empty()) {
+            Node node = queue.top();
+            if (node.distance2 >= bestDistance2) break;
+            queue.pop();
+
+            const Level& lv = levels[node.level];
+            for (int32_t slot = lv.heads[node.y * lv.size + node.x]; slot >= 0; slot = items[slot].next) {
+                float d2 = distanceSquared(items[slot].box, x, y);
+                if (d2 < bestDistance2) {
+                    bestDistance2 = d2;
+                    best = items[slot].id;
+                }
+            }
+            if (node.level == maxDepth) continue;
+            const Level& child = levels[node.level + 1];
+            for (uint32_t k = 0; k < 4; k++) {
+                uint32_t cx = node.x * 2 + (k & 1), cy = node.y * 2 + (k >> 1);
+                if (child.counts[cy * child.size + cx] == 0) continue;
+                float d2 = distanceSquared(looseBounds(node.level + 1, cx, cy), x, y);
+                if (d2 < bestDistance2) queue.push({ d2, node.level + 1, cx, cy });
+            }
+        }
+        return best;
+    }
+};
+
+}  // namespace SpatialIndex
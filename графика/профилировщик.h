@@ -0,0 +1,416 @@
+#pragma once
+#include <GL/glew.h>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "объекты_gl.h"
+
+// ============================================
+// Профилировщик кадра: области CPU и GPU, процентили, экспорт
+// ============================================
+
+// Кадр размечается именованными областями:
+//   profiler.beginFrame();
+//   { Profiler::CpuScope scope(profiler, "физика"); ... }
+//   { Profiler::GpuScope scope(profiler, "отрисовка"); renderQueue.flush(); }
+//   profiler.endFrame();
+// CPU - steady_clock (наносекунды, не скачет при переводе часов). GPU - запросы
+// GL_TIME_ELAPSED: результат читается через несколько кадров из кольца, и только если
+// он уже готов - профилировщик никогда не ждёт GPU. По каждой области за последние
+// WINDOW кадров считаются p50/p95/p99; итоги выгружаются в CSV, события кадров - в
+// JSON трассировки Chrome (chrome://tracing, ui.perfetto.dev).
+// Ключ командной строки: --profile имя (имя.csv и имя.json, см. parseArgs).
+
+namespace Profiler {
+
+enum class Clock { Cpu, Gpu };
+
+// Миллисекунды
+struct Stats {
+    size_t samples;
+    double mean, p50, p95, p99, max;
+};
+
+// --profile имя: префикс файлов выгрузки (nullptr - ключа нет)
+inline const char* parseArgs(int argc, char** argv) {
+    for (int i = 1; i + 1 < argc; i++) {
+        if (std::strcmp(argv[i], "--profile") == 0) return argv[i + 1];
+    }
+    return nullptr;
+}
+
+class FrameProfiler {
+public:
+    static const int GPU_RING = 4;                 // кадров, которые GPU может отставать
+    static const size_t WINDOW = 600;              // кадров для процентилей (10 с при 60 Гц)
+    static const size_t MAX_TRACE_EVENTS = 1 << 20;
+
+private:
+    typedef std::chrono::steady_clock Timer;
+
+    struct Scope {
+        const char* name;
+        Clock clock;
+        std::vector<double> window;    // кольцо последних WINDOW значений, мс
+        size_t next;
+        double frameSum;               // сумма за кадр (в область можно входить несколько раз)
+        bool touched;
+    };
+
+    struct TraceEvent {
+        int scope;
+        double start, duration;        // микросекунды от создания профилировщика
+        uint64_t frame;
+    };
+
+    struct OpenCpu {
+        int scope;
+        Timer::time_point start;
+    };
+
+    struct GpuSample {
+        int scope;
+        double cpuStart;               // когда команда ушла в очередь, мкс
+    };
+
+    // Запросы одного кадра: объекты переиспользуются, когда кольцо возвращается к слоту
+    struct GpuFrame {
+        std::vector<GLHandle::Query> queries;
+        std::vector<GpuSample> samples;
+        uint64_t frame;
+        bool pending;
+    };
+
+    std::vector<Scope> scopes;
+    std::vector<TraceEvent> events;
+    std::vector<OpenCpu> cpuStack;
+    GpuFrame gpuFrames[GPU_RING];
+    bool gpuOpen;
+    bool inFrame;
+    uint64_t frame;
+    uint64_t droppedGpuFrames;
+    Timer::time_point origin, frameStart;
+    int frameScope;
+
+    double micros(Timer::time_point t) const {
+        return std::chrono::duration<double, std::micro>(t - origin).count();
+    }
+
+    // Поиск по указателю, затем по строке: имена - обычно литералы, областей немного
+    int scopeIndex(const char* name, Clock clock) {
+        for (size_t i = 0; i < scopes.size(); i++) {
+            if (scopes[i].clock == clock && (scopes[i].name == name || std::strcmp(scopes[i].name, name) == 0)) {
+                return (int)i;
+            }
+        }
+        scopes.push_back(Scope{ name, clock, std::vector<double>(), 0, 0.0, false });
+        return (int)scopes.size() - 1;
+    }
+
+    void addSample(int scope, double ms) {
+        Scope& s = scopes[scope];
+        if (s.window.size() < WINDOW) s.window.push_back(ms);
+        else s.window[s.next] = ms;
+        s.next = (s.next + 1) % WINDOW;
+    }
+
+    void addEvent(int scope, double start, double duration, uint64_t eventFrame) {
+        if (events.size() < MAX_TRACE_EVENTS) events.push_back(TraceEvent{ scope, start, duration, eventFrame });
+    }
+
+    /*
+    Чтение запросов GPU одного кадра:
+    1. Запросы выполняются по порядку - если готов последний, готовы все
+    2. Не готов - кадр остаётся в кольце до следующей проверки (wait = false)
+    3. В трассировке у GL_TIME_ELAPSED нет момента начала: событие ставится в момент
+       отправки команд, но не раньше конца предыдущего события GPU того же кадра
+    4. Области с одним именем в кадре складываются - отсчёт процентилей на кадр
+    */
+    bool resolve(GpuFrame& slot, bool wait) {
+        if (!slot.pending) return true;
+        if (!slot.samples.empty() && !wait) {
+            GLint available = 0;
+            glGetQueryObjectiv(slot.queries[slot.samples.size() - 1].get(), GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available) return false;
+        }
+
+        double gpuCursor = 0.0;
+        for (size_t i = 0; i < slot.samples.size(); i++) {
+            GLuint64 nanoseconds = 0;
+            glGetQueryObjectui64v(slot.queries[i].get(), GL_QUERY_RESULT, &nanoseconds);
+            double duration = nanoseconds / 1000.0;
+            double start = std::max(slot.samples[i].cpuStart, gpuCursor);
+            gpuCursor = start + duration;
+            addEvent(slot.samples[i].scope, start, duration, slot.frame);
+            scopes[slot.samples[i].scope].frameSum += duration / 1000.0;
+            scopes[slot.samples[i].scope].touched = true;
+        }
+        for (const GpuSample& sample : slot.samples) {
+            Scope& s = scopes[sample.scope];
+            if (!s.touched) continue;
+            addSample(sample.scope, s.frameSum);
+            s.frameSum = 0.0;
+            s.touched = false;
+        }
+        slot.samples.clear();
+        slot.pending = false;
+        return true;
+    }
+
+    // Готовые кадры - от старых к новым, на первом неготовом останавливаемся
+    void collect(bool wait) {
+        for (uint64_t f = frame >= GPU_RING ? frame - GPU_RING : 0; f < frame; f++) {
+            GpuFrame& slot = gpuFrames[f % GPU_RING];
+            if (slot.pending && slot.frame == f && !resolve(slot, wait)) break;
+        }
+    }
+
+    void pushCpuFrameSums() {
+        for (size_t i = 0; i < scopes.size(); i++) {
+            Scope& s = scopes[i];
+            if (s.clock != Clock::Cpu || !s.touched) continue;
+            addSample((int)i, s.frameSum);
+            s.frameSum = 0.0;
+            s.touched = false;
+        }
+    }
+
+public:
+    FrameProfiler() : gpuOpen(false), inFrame(false), frame(0), droppedGpuFrames(0),
+        origin(Timer::now()), frameStart(origin), frameScope(-1) {
+        for (GpuFrame& slot : gpuFrames) {
+            slot.frame = 0;
+            slot.pending = false;
+        }
+        frameScope = scopeIndex("кадр", Clock::Cpu);
+    }
+
+    FrameProfiler(const FrameProfiler&) = delete;
+    FrameProfiler& operator=(const FrameProfiler&) = delete;
+
+    /*
+    Начало кадра (незакрытый прошлый кадр закрывается - можно не звать endFrame
+    перед continue в цикле):
+    1. Забрать готовые результаты GPU прошлых кадров
+    2. Слот кольца для этого кадра ещё ждёт GPU (отставание больше GPU_RING кадров) -
+       его результаты выбрасываются, запросы переиспользуются: лучше потерять
+       отсчёт, чем остановить CPU до конца работы GPU
+    */
+    void beginFrame() {
+        if (inFrame) endFrame();
+        collect(false);
+        GpuFrame& slot = gpuFrames[frame % GPU_RING];
+        if (slot.pending && !resolve(slot, false)) {
+            droppedGpuFrames++;
+            slot.samples.clear();
+            slot.pending = false;
+        }
+        slot.frame = frame;
+        inFrame = true;
+        frameStart = Timer::now();
+    }
+
+    void endFrame() {
+        if (!inFrame) return;
+        while (!cpuStack.empty()) endCpu();
+        if (gpuOpen) endGpu();
+
+        Timer::time_point now = Timer::now();
+        double start = micros(frameStart), duration = micros(now) - start;
+        addEvent(frameScope, start, duration, frame);
+        scopes[frameScope].frameSum += duration / 1000.0;
+        scopes[frameScope].touched = true;
+        pushCpuFrameSums();
+
+        GpuFrame& slot = gpuFrames[frame % GPU_RING];
+        slot.pending = !slot.samples.empty();
+        inFrame = false;
+        frame++;
+    }
+
+    // Области CPU вкладываются
+    void beginCpu(const char* name) {
+        cpuStack.push_back(OpenCpu{ scopeIndex(name, Clock::Cpu), Timer::now() });
+    }
+
+    void endCpu() {
+        if (cpuStack.empty()) return;
+        OpenCpu open = cpuStack.back();
+        cpuStack.pop_back();
+        double start = micros(open.start), duration = micros(Timer::now()) - start;
+        addEvent(open.scope, start, duration, frame);
+        scopes[open.scope].frameSum += duration / 1000.0;
+        scopes[open.scope].touched = true;
+    }
+
+    // Области GPU не вкладываются: GL_TIME_ELAPSED активен только один.
+    // Вложенная beginGpu игнорируется (вместе со своей endGpu - её закроет внешняя)
+    bool beginGpu(const char* name) {
+        if (gpuOpen || !inFrame) return false;
+        GpuFrame& slot = gpuFrames[frame % GPU_RING];
+        if (slot.queries.size() <= slot.samples.size()) slot.queries.push_back(GLHandle::Query::generate());
+        glBeginQuery(GL_TIME_ELAPSED, slot.queries[slot.samples.size()].get());
+        slot.samples.push_back(GpuSample{ scopeIndex(name, Clock::Gpu), micros(Timer::now()) });
+        gpuOpen = true;
+        return true;
+    }
+
+    void endGpu() {
+        if (!gpuOpen) return;
+        glEndQuery(GL_TIME_ELAPSED);
+        gpuOpen = false;
+    }
+
+    // Дождаться всех запросов GPU (в конце работы, перед выгрузкой - здесь ждать можно)
+    void flush() {
+        if (inFrame) endFrame();
+        collect(true);
+    }
+
+    uint64_t getFrame() const { return frame; }
+    uint64_t getDroppedGpuFrames() const { return droppedGpuFrames; }
+
+    // Процентили - ближайший ранг по отсортированной копии окна
+    Stats getStats(const char* name, Clock clock) const {
+        for (const Scope& s : scopes) {
+            if (s.clock == clock && std::strcmp(s.name, name) == 0) return computeStats(s);
+        }
+        return Stats{ 0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+    }
+
+    void printSummary(std::ostream& out) const {
+        std::ios::fmtflags flags = out.flags();
+        std::streamsize precision = out.precision();
+        out << "Профиль (последние " << WINDOW << " кадров, мс):" << std::endl;
+        out << padded("  область", 24) << padded("среднее", 10, true) << std::setw(10) << "p50"
+            << std::setw(10) << "p95" << std::setw(10) << "p99" << std::setw(10) << "max" << std::endl;
+        out << std::fixed << std::setprecision(3);
+        for (const Scope& s : scopes) {
+            Stats st = computeStats(s);
+            if (st.samples == 0) continue;
+            out << padded(std::string("  ") + (s.clock == Clock::Gpu ? "gpu " : "cpu ") + s.name, 24)
+                << std::setw(10) << st.mean << std::setw(10) << st.p50 << std::setw(10) << st.p95
+                << std::setw(10) << st.p99 << std::setw(10) << st.max << std::endl;
+        }
+        if (droppedGpuFrames) out << "  кадров GPU без результата: " << droppedGpuFrames << std::endl;
+        out.flags(flags);
+        out.precision(precision);
+    }
+
+    // Итоги по областям: scope,clock,samples,mean_ms,p50_ms,p95_ms,p99_ms,max_ms
+    bool writeCsv(const char* path) const {
+        std::ofstream file(path);
+        if (!file) return false;
+        file << "scope,clock,samples,mean_ms,p50_ms,p95_ms,p99_ms,max_ms\n";
+        file << std::setprecision(6);
+        for (const Scope& s : scopes) {
+            Stats st = computeStats(s);
+            if (st.samples == 0) continue;
+            file << '"' << s.name << "\"," << (s.clock == Clock::Gpu ? "gpu" : "cpu") << ',' << st.samples << ','
+                << st.mean << ',' << st.p50 << ',' << st.p95 << ',' << st.p99 << ',' << st.max << '\n';
+        }
+        return (bool)file;
+    }
+
+    /*
+    Трассировка в формате Chrome Trace Event (JSON):
+    1. Каждая область - событие "X" (начало и длительность в микросекундах)
+    2. CPU и GPU - две дорожки одного процесса (tid 1 и 2), имена дорожек - событиями "M"
+    3. Номер кадра - в args, по нему события удобно искать в Perfetto
+    */
+    bool writeTrace(const char* path) const {
+        std::ofstream file(path);
+        if (!file) return false;
+        file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}},\n";
+        file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}";
+        file << std::fixed << std::setprecision(3);
+        for (const TraceEvent& e : events) {
+            const Scope& s = scopes[e.scope];
+            file << ",\n{\"name\":\"" << escape(s.name) << "\",\"cat\":\"" << (s.clock == Clock::Gpu ? "gpu" : "cpu")
+                << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << (s.clock == Clock::Gpu ? 2 : 1)
+                << ",\"ts\":" << e.start << ",\"dur\":" << e.duration
+                << ",\"args\":{\"frame\":" << e.frame << "}}";
+        }
+        file << "\n]}\n";
+        return (bool)file;
+    }
+
+    // prefix.csv и prefix.json
+    bool save(const std::string& prefix) const {
+        bool csv = writeCsv((prefix + ".csv").c_str());
+        bool trace = writeTrace((prefix + ".json").c_str());
+        return csv && trace;
+    }
+
+private:
+    static Stats computeStats(const Scope& s) {
+        Stats st = { s.window.size(), 0.0, 0.0, 0.0, 0.0, 0.0 };
+        if (st.samples == 0) return st;
+        std::vector<double> sorted(s.window);
+        std::sort(sorted.begin(), sorted.end());
+        for (double v : sorted) st.mean += v;
+        st.mean /= sorted.size();
+        auto rank = [&](double p) { return sorted[std::min(sorted.size() - 1, (size_t)std::ceil(p * sorted.size()) - 1)]; };
+        st.p50 = rank(0.50);
+        st.p95 = rank(0.95);
+        st.p99 = rank(0.99);
+        st.max = sorted.back();
+        return st;
+    }
+
+    // setw считает байты, а кириллица в UTF-8 - два байта на букву
+    static std::string padded(const std::string& text, size_t width, bool right = false) {
+        size_t letters = 0;
+        for (char c : text) letters += ((unsigned char)c & 0xC0) != 0x80;
+        std::string spaces(letters < width ? width - letters : 1, ' ');
+        return right ? spaces + text : text + spaces;
+    }
+
+    static std::string escape(const char* text) {
+        std::string result;
+        for (const char* c = text; *c; c++) {
+            if (*c == '"' || *c == '\\') result += '\\';
+            if ((unsigned char)*c < 0x20) continue;
+            result += *c;
+        }
+        return result;
+    }
+};
+
+// Область CPU до конца блока
+class CpuScope {
+private:
+    FrameProfiler& profiler;
+
+public:
+    CpuScope(FrameProfiler& profiler, const char* name) : profiler(profiler) { profiler.beginCpu(name); }
+    ~CpuScope() { profiler.endCpu(); }
+
+    CpuScope(const CpuScope&) = delete;
+    CpuScope& operator=(const CpuScope&) = delete;
+};
+
+// Область GPU до конца блока (вложенная в другую GPU-область ничего не меряет)
+class GpuScope {
+private:
+    FrameProfiler& profiler;
+    bool active;
+
+public:
+    GpuScope(FrameProfiler& profiler, const char* name) : profiler(profiler), active(profiler.beginGpu(name)) {}
+    ~GpuScope() { if (active) profiler.endGpu(); }
+
+    GpuScope(const GpuScope&) = delete;
+    GpuScope& operator=(const GpuScope&) = delete;
+};
+
+}  // namespace Profiler
@@ -8,25 +8,38 @@
 #include <glm/common.hpp>
 #include <glm/mat4x4.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include "статичные_меши.h"
+#include "безоконный_режим.h"
+#include "объекты_gl.h"
+#include "очередь_отрисовки.h"
+#include "ломаная.h"
+#include "временной_ряд.h"
+#include "профилировщик.h"
+
+// VAO и VBO - владеющие дескрипторы: фигуру можно переместить (в том числе внутри
+// std::vector), но не скопировать. vertices нужны только до create(): после загрузки
+// на GPU память освобождается, а число вершин остаётся в vertexCount
 class Shape2D {
 protected:
-    unsigned int VAO, VBO;
+    GLHandle::VertexArray VAO;
+    GLHandle::Buffer VBO;
     std::vector<float> vertices;
+    int vertexCount;
     unsigned int drawMode;
     float posX, posY;  // Позиция объекта
 
 public:
-    Shape2D() : posX(0.0f), posY(0.0f) {}
-    virtual ~Shape2D() {
-        glDeleteVertexArrays(1, &VAO);
-        glDeleteBuffers(1, &VBO);
-    }
+    Shape2D() : vertexCount(0), posX(0.0f), posY(0.0f) {}
+    virtual ~Shape2D() = default;
+
+    Shape2D(Shape2D&&) = default;
+    Shape2D& operator=(Shape2D&&) = default;
 
     virtual void create() = 0;
 
     void render() {
-        glBindVertexArray(VAO);
-        glDrawArrays(drawMode, 0, vertices.size() / 5);
+        glBindVertexArray(VAO.get());
+        glDrawArrays(drawMode, 0, vertexCount);
         glBindVertexArray(0);
     }
 
@@ -37,47 +50,19 @@ public:
 
     float getX() const { return posX; }
     float getY() const { return posY; }
-};
 
-class Circle : public Shape2D {
-private:
-    float radius;
+    unsigned int getVertexArray() const { return VAO.get(); }
+    unsigned int getDrawMode() const { return drawMode; }
+    int getVertexCount() const { return vertexCount; }
 
-public:
-    Circle(float r = 0.5f, int segments = 50,
-        float red = 0.0f, float green = 0.0f, float blue = 1.0f)
-        : radius(r) {
-
-        const float M_PI = 3.14159265358979323846f;
-
-        // Центр круга (вершина 0)
-        vertices.push_back(0.0f);  // x
-        vertices.push_back(0.0f);  // y
-        vertices.push_back(red);   // r
-        vertices.push_back(green); // g
-        vertices.push_back(blue);  // b
-
-        // Остальные вершины по окружности
-        for (int i = 0; i <= segments; i++) {
-            float theta = 2.0f * M_PI * float(i) / float(segments);
-            float x = radius * cosf(theta);
-            float y = radius * sinf(theta);
-
-            vertices.push_back(x);  // x
-            vertices.push_back(y);  // y
-            vertices.push_back(red);    // r
-            vertices.push_back(green);  // g
-            vertices.push_back(blue);   // b
-        }
-        drawMode = GL_TRIANGLE_FAN;
-    }
-
-    void create() override {
-        glGenVertexArrays(1, &VAO);
-        glGenBuffers(1, &VBO);
+protected:
+    // Загрузка vertices (x, y, r, g, b) в VBO: атрибут 0 - позиция, 1 - цвет
+    void uploadPositionColor() {
+        VAO = GLHandle::VertexArray::generate();
+        VBO = GLHandle::Buffer::generate();
 
-        glBindVertexArray(VAO);
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBindVertexArray(VAO.get());
+        glBindBuffer(GL_ARRAY_BUFFER, VBO.get());
         glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float),
             vertices.data(), GL_STATIC_DRAW);
 
@@ -93,6 +78,111 @@ public:
 
         glBindBuffer(GL_ARRAY_BUFFER, 0);
         glBindVertexArray(0);
+
+        // Данные уже в VBO - CPU-копия больше не нужна
+        vertexCount = (int)vertices.size() / 5;
+        std::vector<float>().swap(vertices);
+    }
+};
+
+// Прямоугольник [left, right] x [bottom, top] одного цвета (пол сцены)
+class Rectangle : public Shape2D {
+public:
+    Rectangle(float left, float bottom, float right, float top,
+        float red = 0.5f, float green = 0.5f, float blue = 0.5f) {
+        const float corners[4][2] = { { left, bottom }, { right, bottom }, { right, top }, { left, top } };
+        for (const float* corner : corners) {
+            vertices.insert(vertices.end(), { corner[0], corner[1], red, green, blue });
+        }
+        drawMode = GL_TRIANGLE_FAN;
+    }
+
+    void create() override {
+        uploadPositionColor();
+    }
+};
+
+// Круг с фиксированным числом сегментов: единичный веер считается при компиляции
+// и загружается прямо из статической памяти. Радиус применяется матрицей transform,
+// цвет - постоянный атрибут вершины
+template <int Segments>
+class StaticCircle : public Shape2D {
+private:
+    static constexpr std::array<float, (Segments + 2) * 2> positions =
+        StaticMesh::circleFan<Segments>();
+    float radius;
+    float red, green, blue;
+
+public:
+    StaticCircle(float r = 0.5f, float red = 0.0f, float green = 0.0f, float blue = 1.0f)
+        : radius(r), red(red), green(green), blue(blue) {
+        drawMode = GL_TRIANGLE_FAN;
+    }
+
+    void create() override {
+        VAO = GLHandle::VertexArray::generate();
+        VBO = GLHandle::Buffer::generate();
+
+        glBindVertexArray(VAO.get());
+        glBindBuffer(GL_ARRAY_BUFFER, VBO.get());
+        glBufferData(GL_ARRAY_BUFFER, sizeof(positions), positions.data(), GL_STATIC_DRAW);
+
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        glDisableVertexAttribArray(1);
+
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindVertexArray(0);
+    }
+
+    void render() {
+        glVertexAttrib3f(1, red, green, blue);
+        glBindVertexArray(VAO.get());
+        glDrawArrays(drawMode, 0, Segments + 2);
+        glBindVertexArray(0);
+    }
+
+    float getRadius() const { return radius; }
+};
+
+// Круг без треугольного веера: один квадрат [-1.1, 1.1]^2, край круга (радиус 1)
+// вычисляется во фрагментном шейдере по расстоянию до центра со сглаживанием
+// шириной в пиксель. 4 вершины при любом размере, край гладкий при любом масштабе.
+// Рисуется программой sdfVertexShaderSource / sdfFragmentShaderSource, радиус - через transform
+class SDFCircle : public Shape2D {
+private:
+    // Запас 10% за окружностью - место под полосу сглаживания
+    static constexpr float quad[8] = { -1.1f, -1.1f, 1.1f, -1.1f, 1.1f, 1.1f, -1.1f, 1.1f };
+    float radius;
+    float red, green, blue;
+
+public:
+    SDFCircle(float r = 0.5f, float red = 0.0f, float green = 0.0f, float blue = 1.0f)
+        : radius(r), red(red), green(green), blue(blue) {
+        drawMode = GL_TRIANGLE_FAN;
+    }
+
+    void create() override {
+        VAO = GLHandle::VertexArray::generate();
+        VBO = GLHandle::Buffer::generate();
+
+        glBindVertexArray(VAO.get());
+        glBindBuffer(GL_ARRAY_BUFFER, VBO.get());
+        glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        glDisableVertexAttribArray(1);
+
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindVertexArray(0);
+    }
+
+    void render() {
+        glVertexAttrib3f(1, red, green, blue);
+        glBindVertexArray(VAO.get());
+        glDrawArrays(drawMode, 0, 4);
+        glBindVertexArray(0);
     }
 
     float getRadius() const { return radius; }
@@ -138,6 +228,39 @@ void main() {
 }
 )";
 
+// Шейдеры круга по функции расстояния (SDF)
+const char* sdfVertexShaderSource = R"(
+#version 330 core
+layout (location = 0) in vec2 aPos;
+layout (location = 1) in vec3 aColor;
+
+out vec2 localPos;
+out vec3 ourColor;
+uniform mat4 transform;
+
+void main() {
+    gl_Position = transform * vec4(aPos, 0.0, 1.0);
+    localPos = aPos;
+    ourColor = aColor;
+}
+)";
+
+const char* sdfFragmentShaderSource = R"(
+#version 330 core
+in vec2 localPos;
+in vec3 ourColor;
+out vec4 FragColor;
+
+void main() {
+    // Расстояние до окружности (< 0 внутри) и размер пикселя в тех же единицах
+    float d = length(localPos) - 1.0;
+    float w = fwidth(d);
+    float alpha = clamp(0.5 - d / w, 0.0, 1.0);
+    if (alpha <= 0.0) discard;
+    FragColor = vec4(ourColor, alpha);
+}
+)";
+
 // Компиляция шейдера
 unsigned int compileShader(unsigned int type, const char* source) {
     unsigned int shader = glCreateShader(type);
@@ -156,9 +279,10 @@ unsigned int compileShader(unsigned int type, const char* source) {
 }
 
 // Создание шейдерной программы
-unsigned int createShaderProgram() {
-    unsigned int vertexShader = compileShader(GL_VERTEX_SHADER, vertexShaderSource);
-    unsigned int fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentShaderSource);
+unsigned int createShaderProgram(const char* vertexSource = vertexShaderSource,
+    const char* fragmentSource = fragmentShaderSource) {
+    unsigned int vertexShader = compileShader(GL_VERTEX_SHADER, vertexSource);
+    unsigned int fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentSource);
 
     unsigned int shaderProgram = glCreateProgram();
     glAttachShader(shaderProgram, vertexShader);
@@ -179,47 +303,59 @@ unsigned int createShaderProgram() {
     return shaderProgram;
 }
 
-int main() {
-    // Инициализация GLFW
-    if (!glfwInit()) {
-        std::cerr << "Ошибка инициализации GLFW" << std::endl;
-        return -1;
-    }
-
-    // Настройка GLFW
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+int main(int argc, char** argv) {
+    // --headless: без окна, рисование во внеэкранный буфер заданное число кадров
+    Headless::Options headless = Headless::parseArgs(argc, argv, 800, 600);
+    Headless::Context offscreen;
+    GLFWwindow* window = nullptr;
 
-    // Создание окна
-    GLFWwindow* window = glfwCreateWindow(800, 600, "Мячик с арифметической прогрессией", NULL, NULL);
-    if (!window) {
-        std::cerr << "Ошибка создания окна GLFW" << std::endl;
-        glfwTerminate();
-        return -1;
+    if (headless.enabled) {
+        if (!offscreen.create(headless)) return -1;
     }
+    else {
+        // Инициализация GLFW
+        if (!glfwInit()) {
+            std::cerr << "Ошибка инициализации GLFW" << std::endl;
+            return -1;
+        }
+
+        // Настройка GLFW
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+        // Создание окна
+        window = glfwCreateWindow(800, 600, "Мячик с арифметической прогрессией", NULL, NULL);
+        if (!window) {
+            std::cerr << "Ошибка создания окна GLFW" << std::endl;
+            glfwTerminate();
+            return -1;
+        }
 
-    glfwMakeContextCurrent(window);
+        glfwMakeContextCurrent(window);
 
-    // Инициализация GLEW
-    if (glewInit() != GLEW_OK) {
-        std::cerr << "Ошибка инициализации GLEW" << std::endl;
-        return -1;
+        // Инициализация GLEW
+        if (glewInit() != GLEW_OK) {
+            std::cerr << "Ошибка инициализации GLEW" << std::endl;
+            return -1;
+        }
     }
 
-    // Ввод параметров арифметической прогрессии
-    float initialHeight, bounceFactor;
-    int numBounces;
+    // Ввод параметров арифметической прогрессии (в безоконном режиме - значения по умолчанию)
+    float initialHeight = 0.8f, bounceFactor = 0.7f;
+    int numBounces = 5;
 
-    std::cout << "=== visualisation ===" << std::endl;
-    std::cout << "input start height (0.1 - 1.0): ";
-    std::cin >> initialHeight;
+    if (!headless.enabled) {
+        std::cout << "=== visualisation ===" << std::endl;
+        std::cout << "input start height (0.1 - 1.0): ";
+        std::cin >> initialHeight;
 
-    std::cout << "coeficent ymenchenia (0.1 - 0.9): ";
-    std::cin >> bounceFactor;
+        std::cout << "coeficent ymenchenia (0.1 - 0.9): ";
+        std::cin >> bounceFactor;
 
-    std::cout << "amount jumps: ";
-    std::cin >> numBounces;
+        std::cout << "amount jumps: ";
+        std::cin >> numBounces;
+    }
 
     // Ограничиваем значения
     initialHeight = std::max(0.1f, std::min(1.0f, initialHeight));
@@ -237,16 +373,98 @@ int main() {
     // Создание шейдерной программы
     unsigned int shaderProgram = createShaderProgram();
 
-    // Создание мячика
-    Circle ball(0.1f, 50, 1.0f, 0.0f, 0.0f);  // Красный мячик
+    // Создание мячика (USE_TRIANGLE_FAN_BALL - прежний веер из 50 треугольников)
+#ifdef USE_TRIANGLE_FAN_BALL
+    StaticCircle<50> ball(0.1f, 1.0f, 0.0f, 0.0f);  // Красный мячик
+    unsigned int ballProgram = shaderProgram;
+#else
+    SDFCircle ball(0.1f, 1.0f, 0.0f, 0.0f);  // Красный мячик - один квадрат
+    unsigned int ballProgram = createShaderProgram(sdfVertexShaderSource, sdfFragmentShaderSource);
+#endif
     ball.create();
 
+    // Сглаженные края круга и линий смешиваются с фоном (GL_BLEND включают команды)
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    // Графики - ломаные на GPU: точки в буфере, толщина и стыки в шейдере
+    unsigned int lineProgram = createShaderProgram(Polyline::vertexShaderSource, Polyline::fragmentShaderSource);
+
+    // Высоты прыжков: точки загружаются один раз
+    Polyline::Renderer heightGraph;
+    heightGraph.create(lineProgram, bounceHeights.size());
+    heightGraph.setViewport(headless.width, headless.height);
+    heightGraph.setWidth(3.0f);
+    heightGraph.setJoin(Polyline::Join::Miter);
+    heightGraph.setColor(0.0f, 1.0f, 0.0f);
+    for (size_t i = 0; i < bounceHeights.size(); i++) {
+        float x = -0.8f + (i * 1.6f / std::max<size_t>(bounceHeights.size() - 1, 1));
+        float y = -0.8f + (bounceHeights[i] * 0.8f);
+        heightGraph.append(x, y);
+    }
+
+    // Высота мячика во времени: полный ряд хранится на CPU (отсчёт на кадр), на GPU
+    // каждый кадр уходит только прореживание окна - не больше 2 точек на столбец пикселей
+    TimeSeries::Series heightSeries(0.016, 0.016);  // шаг - deltaTime симуляции
+    TimeSeries::Method traceMethod = TimeSeries::Method::MinMax;
+    const int traceColumns = (int)(headless.width * 0.8f);  // график занимает 1.6 NDC по ширине
+    std::vector<float> tracePoints;
+
+    Polyline::Renderer heightTrace;
+    heightTrace.create(lineProgram, traceColumns * 2);
+    heightTrace.setViewport(headless.width, headless.height);
+    heightTrace.setWidth(2.0f);
+    heightTrace.setJoin(Polyline::Join::Round);
+    heightTrace.setColor(1.0f, 0.8f, 0.2f);
+    float traceWindow = 4.0f;  // секунд на ширину графика (в окне: стрелки вверх/вниз, M - метод)
+    bool methodKeyDown = false;
+
     // Настройка OpenGL
     glUseProgram(shaderProgram);
     glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
 
     // Получение location uniform-переменной transform
-    int transformLoc = glGetUniformLocation(shaderProgram, "transform");
+    int transformLoc = glGetUniformLocation(ballProgram, "transform");
+
+    // Пол - прямоугольник в VBO, рисуется основной программой с единичной матрицей
+    Rectangle floor(-1.0f, -1.0f, 1.0f, -0.9f);
+    floor.create();
+    int floorTransformLoc = glGetUniformLocation(shaderProgram, "transform");
+
+    // Кадр собирается в очередь и рисуется одним проходом: фон (пол - основная
+    // программа, графики - программа ломаных) подряд, затем мячик
+    RenderQueue::Queue renderQueue;
+    const uint8_t LAYER_BACKGROUND = 0, LAYER_BALL = 1;
+
+    // Данные для команды мячика: callback - функция без захвата, всё через userData
+    struct BallDraw {
+        decltype(ball)* shape;
+        int transformLoc;
+        glm::mat4 transform;
+    };
+    BallDraw ballDraw = { &ball, transformLoc, glm::mat4(1.0f) };
+
+    // Пол - обычная команда: программа, VAO и число вершин; callback только ставит матрицу
+    // (с USE_TRIANGLE_FAN_BALL программа общая с мячиком, и его матрица осталась бы)
+    RenderQueue::DrawCommand floorCommand;
+    floorCommand.program = shaderProgram;
+    floorCommand.vertexArray = floor.getVertexArray();
+    floorCommand.mode = floor.getDrawMode();
+    floorCommand.count = floor.getVertexCount();
+    floorCommand.callback = [](const RenderQueue::DrawCommand& c) {
+        glm::mat4 identity(1.0f);
+        glUniformMatrix4fv(*(const int*)c.userData, 1, GL_FALSE, &identity[0][0]);
+    };
+    floorCommand.userData = &floorTransformLoc;
+
+    RenderQueue::DrawCommand ballCommand;
+    ballCommand.program = ballProgram;
+    ballCommand.blend = ballProgram != shaderProgram;
+    ballCommand.callback = [](const RenderQueue::DrawCommand& c) {
+        const BallDraw& draw = *(const BallDraw*)c.userData;
+        glUniformMatrix4fv(draw.transformLoc, 1, GL_FALSE, &draw.transform[0][0]);
+        draw.shape->render();
+    };
+    ballCommand.userData = &ballDraw;
 
     // Переменные для анимации
     float currentTime = 0.0f;
@@ -257,12 +475,18 @@ int main() {
     float velocity = 0.0f;
     const float gravity = -2.0f;
 
+    // Время кадра по областям (--profile имя - выгрузка в имя.csv и имя.json)
+    const char* profileOutput = Profiler::parseArgs(argc, argv);
+    Profiler::FrameProfiler profiler;
+
     // Основной цикл
-    while (!glfwWindowShouldClose(window)) {
+    while (headless.enabled ? offscreen.nextFrame() : !glfwWindowShouldClose(window)) {
+        profiler.beginFrame();
         glClear(GL_COLOR_BUFFER_BIT);
+        profiler.beginCpu("физика");
 
         // Расчет времени
-        float time = glfwGetTime();
+        float time = headless.enabled ? offscreen.getTime() : glfwGetTime();
         float deltaTime = 0.016f;  // Примерно 60 FPS
 
         // Физика мячика (упрощенная)
@@ -286,57 +510,88 @@ int main() {
 
                 // Изменение цвета мячика в зависимости от высоты
                 float colorIntensity = bounceHeights[currentBounce] / initialHeight;
-                glUseProgram(0);  // Временно отключаем шейдер
                 // Здесь можно изменить цвет мячика
-                glUseProgram(shaderProgram);
             }
         }
 
+        profiler.endCpu();
+
+        // Новый отсчёт и прореживание последних traceWindow секунд (x точек - от начала окна)
+        profiler.beginCpu("график");
+        heightSeries.append(ballY);
+        double viewEnd = heightSeries.getEnd();
+        heightSeries.decimate(viewEnd - traceWindow, viewEnd, traceColumns, traceMethod, tracePoints);
+        heightTrace.clear();
+        heightTrace.append(tracePoints.data(), tracePoints.size() / 2);
+
+        float traceScaleX = 1.6f / traceWindow;
+        glm::mat4 traceTransform = glm::translate(glm::mat4(1.0f), glm::vec3(-0.8f, 0.55f, 0.0f));
+        // После подъёма мячик летит вверх по инерции - верх графика на 2 * initialHeight
+        traceTransform = glm::scale(traceTransform, glm::vec3(traceScaleX, 0.4f / (2.0f * initialHeight), 1.0f));
+        heightTrace.setTransform(&traceTransform[0][0]);
+        profiler.endCpu();
+
         // Создание матрицы трансформации для мячика
         float scale = 0.5f;  // Масштабирование для OpenGL координат
         glm::mat4 transform = glm::mat4(1.0f);
         transform = glm::translate(transform, glm::vec3(ballX, ballY * scale, 0.0f));
-
-        // Передача матрицы трансформации в шейдер
-        glUniformMatrix4fv(transformLoc, 1, GL_FALSE, &transform[0][0]);
-
-        // Отрисовка мячика
-        ball.render();
-
-        // Отрисовка пола
-        glUseProgram(0);  // Используем фиксированный конвейер для простоты
-        glColor3f(0.5f, 0.5f, 0.5f);
-        glBegin(GL_QUADS);
-        glVertex2f(-1.0f, -0.9f);
-        glVertex2f(1.0f, -0.9f);
-        glVertex2f(1.0f, -1.0f);
-        glVertex2f(-1.0f, -1.0f);
-        glEnd();
-        glUseProgram(shaderProgram);
-
-        // Отрисовка графиков высот (опционально)
-        glUseProgram(0);
-        glColor3f(0.0f, 1.0f, 0.0f);
-        glBegin(GL_LINE_STRIP);
-        for (size_t i = 0; i < bounceHeights.size(); i++) {
-            float x = -0.8f + (i * 1.6f / (bounceHeights.size() - 1));
-            float y = -0.8f + (bounceHeights[i] * 0.8f);
-            glVertex2f(x, y);
+        transform = glm::scale(transform, glm::vec3(ball.getRadius()));
+
+        // Матрица уходит в шейдер из callback команды мячика
+        ballDraw.transform = transform;
+
+        // Пол, график прыжков и след высоты - фон, мячик поверх них
+        renderQueue.submit(floorCommand, LAYER_BACKGROUND);
+        renderQueue.submit(heightGraph.command(), LAYER_BACKGROUND);
+        renderQueue.submit(heightTrace.command(), LAYER_BACKGROUND);
+        renderQueue.submit(ballCommand, LAYER_BALL);
+        {
+            Profiler::CpuScope cpuScope(profiler, "отрисовка");
+            Profiler::GpuScope gpuScope(profiler, "отрисовка");
+            renderQueue.flush();
         }
-        glEnd();
-        glUseProgram(shaderProgram);
 
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        if (!headless.enabled) {
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+
+            // Масштаб графика: от секунды до всей истории
+            if (glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS) traceWindow *= 1.05f;
+            if (glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS) traceWindow /= 1.05f;
+            traceWindow = std::max(1.0f, std::min(traceWindow, (float)heightSeries.getEnd()));
+            bool methodKey = glfwGetKey(window, GLFW_KEY_M) == GLFW_PRESS;
+            if (methodKey && !methodKeyDown) {
+                traceMethod = traceMethod == TimeSeries::Method::MinMax ?
+                    TimeSeries::Method::LTTB : TimeSeries::Method::MinMax;
+            }
+            methodKeyDown = methodKey;
+
+            // Небольшая задержка для контроля скорости анимации
+            std::this_thread::sleep_for(std::chrono::milliseconds(16));
+        }
+        profiler.endFrame();
+    }
 
-        // Небольшая задержка для контроля скорости анимации
-        std::this_thread::sleep_for(std::chrono::milliseconds(16));
+    profiler.flush();
+    profiler.printSummary(std::cout);
+    if (profileOutput && !profiler.save(profileOutput)) {
+        std::cerr << "Не удалось сохранить профиль " << profileOutput << std::endl;
     }
 
+    std::cout << "График высоты: отсчётов " << heightSeries.size()
+        << ", точек в последнем кадре " << heightTrace.size() << std::endl;
+
     // Очистка
     glDeleteProgram(shaderProgram);
-    glfwDestroyWindow(window);
-    glfwTerminate();
+    glDeleteProgram(lineProgram);
+    if (ballProgram != shaderProgram) glDeleteProgram(ballProgram);
+    if (headless.enabled) {
+        offscreen.finish();
+    }
+    else {
+        glfwDestroyWindow(window);
+        glfwTerminate();
+    }
 
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,250 @@
+#pragma once
+#include <GL/glew.h>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+#include <iterator>
+#include <utility>
+#include <algorithm>
+#include "объекты_gl.h"
+
+// ============================================
+// Общий буфер вершин с распределителем диапазонов
+// ============================================
+
+// Вместо glGenBuffers + glBufferData на каждую мелкую фигуру - один большой VBO,
+// из которого выделяются диапазоны байт. Владелец получает не буфер, а дескриптор:
+// смещение по нему может измениться при дефрагментации, поэтому его спрашивают
+// перед каждой отрисовкой. Если места не хватает, буфер удваивается (объект
+// буфера при этом меняется - см. getGeneration()).
+
+namespace GeometryPool {
+
+typedef uint32_t Handle;
+const Handle INVALID_HANDLE = 0;
+
+// Выравнивание не обязательно степень двойки: для glDrawArrays(first) смещение
+// должно быть кратно размеру вершины, например 20 байтам
+inline size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+/*
+Распределитель диапазонов (first-fit по списку свободных блоков):
+1. Свободные блоки хранятся в std::map по смещению - соседей легко найти
+2. allocate: первый блок, в который помещается выровненный диапазон; остатки
+   слева и справа возвращаются в список
+3. free: блок вставляется и сливается с соседями, если они вплотную
+Ограничение limit нужно дефрагментации: она ищет место только левее текущего.
+*/
+class RangeAllocator {
+private:
+    std::map<size_t, size_t> freeBlocks;  // смещение -> размер
+    size_t capacity;
+
+public:
+    RangeAllocator() : capacity(0) {}
+
+    void reset(size_t newCapacity) {
+        freeBlocks.clear();
+        capacity = newCapacity;
+        if (capacity > 0) freeBlocks[0] = capacity;
+    }
+
+    // Расширить пространство: новый хвост становится свободным
+    void grow(size_t newCapacity) {
+        if (newCapacity <= capacity) return;
+        size_t oldCapacity = capacity;
+        capacity = newCapacity;
+        free(oldCapacity, newCapacity - oldCapacity);
+    }
+
+    bool allocate(size_t size, size_t alignment, size_t& offset, size_t limit = SIZE_MAX) {
+        for (auto it = freeBlocks.begin(); it != freeBlocks.end() && it->first < limit; ++it) {
+            size_t blockStart = it->first;
+            size_t blockEnd = blockStart + it->second;
+            size_t start = alignUp(blockStart, alignment);
+            if (start + size > blockEnd || start + size > limit) continue;
+
+            freeBlocks.erase(it);
+            if (start > blockStart) freeBlocks[blockStart] = start - blockStart;
+            if (blockEnd > start + size) freeBlocks[start + size] = blockEnd - (start + size);
+            offset = start;
+            return true;
+        }
+        return false;
+    }
+
+    void free(size_t offset, size_t size) {
+        auto next = freeBlocks.lower_bound(offset);
+        if (next != freeBlocks.end() && offset + size == next->first) {
+            size += next->second;
+            next = freeBlocks.erase(next);
+        }
+        if (next != freeBlocks.begin()) {
+            auto prev = std::prev(next);
+            if (prev->first + prev->second == offset) {
+                prev->second += size;
+                return;
+            }
+        }
+        freeBlocks.emplace_hint(next, offset, size);
+    }
+
+    // Начало первой дыры: всё, что левее, уже плотно упаковано
+    size_t firstFreeOffset() const {
+        return freeBlocks.empty() ? capacity : freeBlocks.begin()->first;
+    }
+
+    size_t freeBlockCount() const { return freeBlocks.size(); }
+
+    size_t largestFreeBlock() const {
+        size_t largest = 0;
+        for (const auto& block : freeBlocks) largest = std::max(largest, block.second);
+        return largest;
+    }
+};
+
+class VertexMegabuffer {
+private:
+    struct Allocation {
+        size_t offset;
+        size_t size;
+        size_t alignment;
+    };
+
+    GLHandle::Buffer buffer;
+    size_t capacity;
+    size_t used;
+    size_t movedBytes;
+    unsigned int generation;
+    RangeAllocator ranges;
+    std::vector<Allocation> allocations;     // по дескриптору - 1
+    std::vector<Handle> freeHandles;
+    std::map<size_t, Handle> byOffset;       // живые диапазоны по возрастанию смещения
+
+    // Новый буфер вдвое больше; содержимое копируется на GPU, смещения не меняются
+    void grow(size_t required) {
+        size_t newCapacity = std::max(capacity * 2, capacity + required);
+        GLHandle::Buffer newBuffer = GLHandle::Buffer::generate();
+        glBindBuffer(GL_COPY_WRITE_BUFFER, newBuffer.get());
+        glBufferData(GL_COPY_WRITE_BUFFER, newCapacity, NULL, GL_STATIC_DRAW);
+        if (buffer) {
+            glBindBuffer(GL_COPY_READ_BUFFER, buffer.get());
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, capacity);
+            glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        }
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+        buffer = std::move(newBuffer);  // старый буфер удаляется здесь
+        ranges.grow(newCapacity);
+        capacity = newCapacity;
+        generation++;
+    }
+
+public:
+    VertexMegabuffer() : capacity(0), used(0), movedBytes(0), generation(0) {}
+
+    void create(size_t initialCapacity) {
+        ranges.reset(0);
+        grow(initialCapacity);
+    }
+
+    Handle allocate(size_t size, size_t alignment) {
+        if (size == 0) return INVALID_HANDLE;
+        size_t offset;
+        if (!ranges.allocate(size, alignment, offset)) {
+            grow(size + alignment);
+            ranges.allocate(size, alignment, offset);
+        }
+
+        Handle handle;
+        if (!freeHandles.empty()) {
+            handle = freeHandles.back();
+            freeHandles.pop_back();
+            allocations[handle - 1] = { offset, size, alignment };
+        }
+        else {
+            allocations.push_back({ offset, size, alignment });
+            handle = (Handle)allocations.size();
+        }
+        byOffset[offset] = handle;
+        used += size;
+        return handle;
+    }
+
+    void free(Handle handle) {
+        if (handle == INVALID_HANDLE) return;
+        Allocation& allocation = allocations[handle - 1];
+        ranges.free(allocation.offset, allocation.size);
+        byOffset.erase(allocation.offset);
+        used -= allocation.size;
+        allocation.size = 0;
+        freeHandles.push_back(handle);
+    }
+
+    void upload(Handle handle, const void* data, size_t size) {
+        if (handle == INVALID_HANDLE) return;
+        const Allocation& allocation = allocations[handle - 1];
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer.get());
+        glBufferSubData(GL_COPY_WRITE_BUFFER, allocation.offset, std::min(size, allocation.size), data);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+
+    size_t getOffset(Handle handle) const {
+        return handle == INVALID_HANDLE ? 0 : allocations[handle - 1].offset;
+    }
+
+    /*
+    Пошаговая дефрагментация (вызывать раз в кадр, вместо фонового потока -
+    команды GL всё равно выполняются в потоке контекста):
+    1. Диапазоны перебираются с конца буфера
+    2. Для каждого ищется свободное место левее (first-fit с ограничением) -
+       оно не пересекается с исходным, так что хватает одного glCopyBufferSubData
+    3. Старое место освобождается и сливается с соседями; дыры "всплывают" в хвост
+    4. Останавливаемся, когда дошли до первой дыры или исчерпали бюджет байт
+    Отрисовки, уже отправленные со старым смещением, корректны: GL выполняет
+    команды по порядку.
+    */
+    size_t defragment(size_t budgetBytes) {
+        size_t moved = 0;
+        size_t firstHole = ranges.firstFreeOffset();
+        auto it = byOffset.end();
+        glBindBuffer(GL_COPY_READ_BUFFER, buffer.get());
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer.get());
+        while (moved < budgetBytes && it != byOffset.begin()) {
+            --it;
+            if (it->first < firstHole) break;
+
+            Handle handle = it->second;
+            Allocation& allocation = allocations[handle - 1];
+            size_t target;
+            if (!ranges.allocate(allocation.size, allocation.alignment, target, it->first)) continue;
+
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+                allocation.offset, target, allocation.size);
+            ranges.free(allocation.offset, allocation.size);
+            it = byOffset.erase(it);
+            byOffset[target] = handle;
+            allocation.offset = target;
+            moved += allocation.size;
+            firstHole = ranges.firstFreeOffset();
+        }
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        movedBytes += moved;
+        return moved;
+    }
+
+    unsigned int getBuffer() const { return buffer.get(); }
+    // Меняется при замене объекта буфера - VAO нужно перепривязать
+    unsigned int getGeneration() const { return generation; }
+    size_t getCapacity() const { return capacity; }
+    size_t getUsed() const { return used; }
+    size_t getMovedBytes() const { return movedBytes; }
+    size_t getAllocationCount() const { return byOffset.size(); }
+    size_t getFreeBlockCount() const { return ranges.freeBlockCount(); }
+};
+
+}  // namespace GeometryPool
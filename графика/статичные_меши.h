@@ -0,0 +1,151 @@
+#pragma once
+#include <array>
+#include <cstddef>
+
+// ============================================
+// Генерация мешей на этапе компиляции (constexpr)
+// ============================================
+
+// Данные фиксированного разрешения вычисляются компилятором и лежат в .rodata:
+// при запуске программы ничего не считается, загрузка в VBO идёт прямо из статической памяти.
+
+namespace StaticMesh {
+
+constexpr double PI = 3.14159265358979323846;
+
+// Ряд Тейлора на [-pi/4, pi/4]
+constexpr double sinSeries(double x) {
+    double x2 = x * x;
+    double term = x;
+    double sum = x;
+    for (int n = 1; n < 10; n++) {
+        term *= -x2 / ((2 * n) * (2 * n + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr double cosSeries(double x) {
+    double x2 = x * x;
+    double term = 1.0;
+    double sum = 1.0;
+    for (int n = 1; n < 10; n++) {
+        term *= -x2 / ((2 * n - 1) * (2 * n));
+        sum += term;
+    }
+    return sum;
+}
+
+// Приведение к четверти: x = k * pi/2 + r, |r| <= pi/4
+constexpr double sin(double x) {
+    double q = x / (PI / 2);
+    long long k = (long long)(q >= 0 ? q + 0.5 : q - 0.5);
+    double r = x - k * (PI / 2);
+    switch (((k % 4) + 4) % 4) {
+    case 0: return sinSeries(r);
+    case 1: return cosSeries(r);
+    case 2: return -sinSeries(r);
+    default: return -cosSeries(r);
+    }
+}
+
+constexpr double cos(double x) {
+    return sin(x + PI / 2);
+}
+
+// Умножение всех координат на коэффициент (например, радиус)
+template <size_t N>
+constexpr std::array<float, N> scaled(std::array<float, N> data, float factor) {
+    for (size_t i = 0; i < N; i++) {
+        data[i] *= factor;
+    }
+    return data;
+}
+
+// Окружность единичного радиуса для GL_TRIANGLE_FAN: Segments + 1 точек (x, y) по краю,
+// последняя совпадает с первой
+template <int Segments>
+constexpr std::array<float, (Segments + 1) * 2> circleRim() {
+    std::array<float, (Segments + 1) * 2> data{};
+    for (int i = 0; i <= Segments; i++) {
+        double theta = 2.0 * PI * (i % Segments) / Segments;
+        data[i * 2] = (float)cos(theta);
+        data[i * 2 + 1] = (float)sin(theta);
+    }
+    return data;
+}
+
+// То же, но с центром (0, 0) первой вершиной веера
+template <int Segments>
+constexpr std::array<float, (Segments + 2) * 2> circleFan() {
+    std::array<float, (Segments + 2) * 2> data{};
+    std::array<float, (Segments + 1) * 2> rim = circleRim<Segments>();
+    for (int i = 0; i < (Segments + 1) * 2; i++) {
+        data[i + 2] = rim[i];
+    }
+    return data;
+}
+
+// Индексированная UV-сфера единичного радиуса: позиция + нормаль (6 float на вершину)
+// Раскладка вершин и индексов та же, что у Sphere::generateSphere
+template <int Sectors, int Stacks>
+struct SphereMesh {
+    static_assert(Sectors >= 3 && Stacks >= 2, "Слишком грубая сфера");
+
+    static constexpr int VERTEX_COUNT = (Stacks + 1) * (Sectors + 1);
+    static constexpr int INDEX_COUNT = Sectors * (Stacks - 1) * 6;
+
+    static_assert(VERTEX_COUNT <= 65536, "Индексы не помещаются в 16 бит");
+
+    static constexpr std::array<float, VERTEX_COUNT * 6> makeVertices() {
+        std::array<float, VERTEX_COUNT * 6> data{};
+        int k = 0;
+        for (int i = 0; i <= Stacks; i++) {
+            double stackAngle = PI / 2 - i * PI / Stacks;
+            double xy = cos(stackAngle);
+            double z = sin(stackAngle);
+
+            for (int j = 0; j <= Sectors; j++) {
+                double sectorAngle = 2.0 * PI * (j % Sectors) / Sectors;
+                float x = (float)(xy * cos(sectorAngle));
+                float y = (float)(xy * sin(sectorAngle));
+
+                data[k++] = x;
+                data[k++] = y;
+                data[k++] = (float)z;
+                data[k++] = x;
+                data[k++] = y;
+                data[k++] = (float)z;
+            }
+        }
+        return data;
+    }
+
+    static constexpr std::array<unsigned short, INDEX_COUNT> makeIndices() {
+        std::array<unsigned short, INDEX_COUNT> data{};
+        int n = 0;
+        for (int i = 0; i < Stacks; i++) {
+            int k1 = i * (Sectors + 1);
+            int k2 = k1 + Sectors + 1;
+
+            for (int j = 0; j < Sectors; j++, k1++, k2++) {
+                if (i != 0) {
+                    data[n++] = (unsigned short)k1;
+                    data[n++] = (unsigned short)(k1 + 1);
+                    data[n++] = (unsigned short)k2;
+                }
+                if (i != Stacks - 1) {
+                    data[n++] = (unsigned short)k2;
+                    data[n++] = (unsigned short)(k1 + 1);
+                    data[n++] = (unsigned short)(k2 + 1);
+                }
+            }
+        }
+        return data;
+    }
+
+    static constexpr std::array<float, VERTEX_COUNT * 6> vertices = makeVertices();
+    static constexpr std::array<unsigned short, INDEX_COUNT> indices = makeIndices();
+};
+
+}  // namespace StaticMesh
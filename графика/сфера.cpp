@@ -3,6 +3,17 @@
 #include <iostream>
 #include <vector>
 #include <cmath>
+#include <memory>
+#include <cstddef>
+#include <cstring>
+#include <unordered_map>
+#include <string>
+#include <algorithm>
+#include "статичные_меши.h"
+#include "упаковка_вершин.h"
+#include "матрицы_simd.h"
+#include "отсечение_пирамиды.h"
+#include "безоконный_режим.h"
 
 // ============================================
 // РЕШЕНИЕ 1: Использовать правильные заголовки GLM
@@ -21,6 +32,14 @@
 // ============================================
 
 class SimpleMath {
+private:
+    static constexpr float IDENTITY[16] = {
+        1.0f, 0.0f, 0.0f, 0.0f,
+        0.0f, 1.0f, 0.0f, 0.0f,
+        0.0f, 0.0f, 1.0f, 0.0f,
+        0.0f, 0.0f, 0.0f, 1.0f
+    };
+
 public:
     // Конвертация градусов в радианы
     static float toRadians(float degrees) {
@@ -29,9 +48,7 @@ public:
 
     // Создание матрицы переноса 4x4
     static void createTranslationMatrix(float tx, float ty, float tz, float* matrix) {
-        // Инициализация как единичная матрица
-        for (int i = 0; i < 16; i++) matrix[i] = 0.0f;
-        matrix[0] = matrix[5] = matrix[10] = matrix[15] = 1.0f;
+        std::memcpy(matrix, IDENTITY, sizeof(IDENTITY));
 
         // Установка компонентов переноса
         matrix[12] = tx;
@@ -44,13 +61,11 @@ public:
         float cosA = cos(angle);
         float sinA = sin(angle);
 
-        for (int i = 0; i < 16; i++) matrix[i] = 0.0f;
-        matrix[0] = 1.0f;
+        std::memcpy(matrix, IDENTITY, sizeof(IDENTITY));
         matrix[5] = cosA;
         matrix[6] = -sinA;
         matrix[9] = sinA;
         matrix[10] = cosA;
-        matrix[15] = 1.0f;
     }
 
     // Создание матрицы вращения вокруг оси Y
@@ -58,38 +73,50 @@ public:
         float cosA = cos(angle);
         float sinA = sin(angle);
 
-        for (int i = 0; i < 16; i++) matrix[i] = 0.0f;
+        std::memcpy(matrix, IDENTITY, sizeof(IDENTITY));
         matrix[0] = cosA;
         matrix[2] = sinA;
-        matrix[5] = 1.0f;
         matrix[8] = -sinA;
         matrix[10] = cosA;
-        matrix[15] = 1.0f;
     }
 
     // Создание матрицы перспективной проекции
     static void createPerspectiveMatrix(float fov, float aspect, float near, float far, float* matrix) {
         float f = 1.0f / tan(fov / 2.0f);
 
-        for (int i = 0; i < 16; i++) matrix[i] = 0.0f;
-
-        matrix[0] = f / aspect;
-        matrix[5] = f;
-        matrix[10] = (far + near) / (near - far);
-        matrix[11] = -1.0f;
-        matrix[14] = (2.0f * far * near) / (near - far);
+        const float m[16] = {
+            f / aspect, 0.0f, 0.0f, 0.0f,
+            0.0f, f, 0.0f, 0.0f,
+            0.0f, 0.0f, (far + near) / (near - far), -1.0f,
+            0.0f, 0.0f, (2.0f * far * near) / (near - far), 0.0f
+        };
+        std::memcpy(matrix, m, sizeof(m));
     }
 
-    // Умножение матриц 4x4
+    // Умножение матриц 4x4: result[i * 4 + j] = сумма a[i * 4 + k] * b[k * 4 + j]
+    // (для матриц OpenGL, хранящихся по столбцам, это произведение b * a)
     static void multiplyMatrices(const float* a, const float* b, float* result) {
-        for (int i = 0; i < 4; i++) {
-            for (int j = 0; j < 4; j++) {
-                result[i * 4 + j] = 0.0f;
-                for (int k = 0; k < 4; k++) {
-                    result[i * 4 + j] += a[i * 4 + k] * b[k * 4 + j];
-                }
-            }
-        }
+        MatrixSIMD::multiply(b, a, result);
+    }
+
+    // Обратная матрица (false, если матрица вырожденная)
+    static bool invertMatrix(const float* matrix, float* result) {
+        return MatrixSIMD::inverse(matrix, result);
+    }
+
+    // Транспонирование
+    static void transposeMatrix(const float* matrix, float* result) {
+        MatrixSIMD::transpose(matrix, result);
+    }
+
+    // Преобразование массива позиций (x, y, z подряд) матрицей OpenGL
+    static void transformPositions(const float* matrix, const float* in, float* out, size_t count) {
+        MatrixSIMD::transformPositionsAoS(matrix, in, out, count);
+    }
+
+    // Преобразование массива нормалей (без переноса)
+    static void transformNormals(const float* matrix, const float* in, float* out, size_t count) {
+        MatrixSIMD::transformNormalsAoS(matrix, in, out, count);
     }
 };
 
@@ -102,14 +129,33 @@ layout (location = 1) in vec3 aNormal;
 out vec3 FragPos;
 out vec3 Normal;
 
+// Общий блок камеры и света (один буфер на все программы)
+layout (std140) uniform Camera
+{
+    mat4 view;
+    mat4 projection;
+    vec4 viewPos;
+    vec4 lightPos;
+    vec4 lightColor;
+};
+
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+uniform bool octNormals;  // нормаль упакована в 2 x snorm16 (aNormal.xy)
+
+vec3 octDecode(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
 
 void main()
 {
     FragPos = vec3(model * vec4(aPos, 1.0));
-    Normal = aNormal;  // Упрощенно, без учета вращения модели
+    // Упрощенно, без учета вращения модели
+    Normal = octNormals ? octDecode(aNormal.xy) : aNormal;
     
     gl_Position = projection * view * vec4(FragPos, 1.0);
 }
@@ -123,18 +169,24 @@ in vec3 Normal;
 
 out vec4 FragColor;
 
-uniform vec3 lightPos;
-uniform vec3 viewPos;
-uniform vec3 lightColor;
+layout (std140) uniform Camera
+{
+    mat4 view;
+    mat4 projection;
+    vec4 viewPos;
+    vec4 lightPos;
+    vec4 lightColor;
+};
+
 uniform vec3 objectColor;
 
 void main()
 {
     // Упрощенное освещение
     vec3 norm = normalize(Normal);
-    vec3 lightDir = normalize(lightPos - FragPos);
+    vec3 lightDir = normalize(lightPos.xyz - FragPos);
     float diff = max(dot(norm, lightDir), 0.0);
-    vec3 diffuse = diff * lightColor;
+    vec3 diffuse = diff * lightColor.rgb;
     
     vec3 ambient = vec3(0.1, 0.1, 0.1);
     vec3 result = (ambient + diffuse) * objectColor;
@@ -143,135 +195,661 @@ void main()
 }
 )";
 
+// Вершинный шейдер для экземпляров: позиция/радиус и цвет берутся из буфера экземпляров
+const char* instancedVertexShaderSource = R"(
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec4 iPositionRadius;  // xyz - центр, w - радиус
+layout (location = 3) in vec4 iColor;
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec3 Color;
+
+layout (std140) uniform Camera
+{
+    mat4 view;
+    mat4 projection;
+    vec4 viewPos;
+    vec4 lightPos;
+    vec4 lightColor;
+};
+
+void main()
+{
+    FragPos = iPositionRadius.xyz + aPos * iPositionRadius.w;
+    Normal = aNormal;
+    Color = iColor.rgb;
+
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
+)";
+
+// Фрагментный шейдер для экземпляров (цвет из вершинного шейдера)
+const char* instancedFragmentShaderSource = R"(
+#version 330 core
+in vec3 FragPos;
+in vec3 Normal;
+in vec3 Color;
+
+out vec4 FragColor;
+
+layout (std140) uniform Camera
+{
+    mat4 view;
+    mat4 projection;
+    vec4 viewPos;
+    vec4 lightPos;
+    vec4 lightColor;
+};
+
+void main()
+{
+    vec3 norm = normalize(Normal);
+    vec3 lightDir = normalize(lightPos.xyz - FragPos);
+    float diff = max(dot(norm, lightDir), 0.0);
+    vec3 diffuse = diff * lightColor.rgb;
+
+    vec3 ambient = vec3(0.1, 0.1, 0.1);
+    FragColor = vec4((ambient + diffuse) * Color, 1.0);
+}
+)";
+
+// Формат вершин сферы
+enum class VertexFormat {
+    Float,   // позиция 3 x float + нормаль 3 x float (24 байта)
+    Packed   // позиция 3 x snorm16 (+ масштаб меша) + нормаль 2 x snorm16 oct (12 байт)
+};
+
+// Упакованная вершина: xyz и w-выравнивание, затем октаэдрическая нормаль
+struct PackedSphereVertex {
+    int16_t position[4];
+    int16_t normal[2];
+};
+
 // Класс для генерации сферы
 class Sphere {
 private:
-    unsigned int VAO, VBO;
-    int vertexCount;
+    unsigned int VAO, VBO, EBO;
+    int indexCount;
+    GLenum indexType;  // GL_UNSIGNED_SHORT или GL_UNSIGNED_INT
+    VertexFormat format = VertexFormat::Float;
+    float positionScale = 1.0f;
 
 public:
-    Sphere(float radius = 1.0f, int sectors = 32, int stacks = 16) {
+    Sphere(float radius = 1.0f, int sectors = 32, int stacks = 16,
+        VertexFormat format = VertexFormat::Float) : format(format) {
         generateSphere(radius, sectors, stacks);
     }
 
+    // Сфера из готовых данных (например, StaticMesh::SphereMesh):
+    // загрузка прямо из статической памяти, без генерации при запуске
+    Sphere(const float* vertices, int vertexCount, const unsigned short* indices, int indexCount) {
+        upload(vertices, vertexCount, indices, indexCount, GL_UNSIGNED_SHORT);
+    }
+
     ~Sphere() {
         glDeleteVertexArrays(1, &VAO);
         glDeleteBuffers(1, &VBO);
+        glDeleteBuffers(1, &EBO);
     }
 
     void render() {
         glBindVertexArray(VAO);
-        glDrawArrays(GL_TRIANGLES, 0, vertexCount);
+        glDrawElements(GL_TRIANGLES, indexCount, indexType, 0);
         glBindVertexArray(0);
     }
 
+    // Отрисовка count экземпляров (атрибуты экземпляров настраиваются в VAO заранее)
+    void renderInstanced(int count) {
+        glBindVertexArray(VAO);
+        glDrawElementsInstanced(GL_TRIANGLES, indexCount, indexType, 0, count);
+        glBindVertexArray(0);
+    }
+
+    unsigned int getVAO() const { return VAO; }
+
+    VertexFormat getFormat() const { return format; }
+
+    // Для Packed позиции хранятся в [-1, 1]: матрицу модели нужно домножить на этот масштаб
+    float getPositionScale() const { return positionScale; }
+
 private:
+    /*
+    Индексированная сфера:
+    1. Каждая вершина сетки (stacks + 1) x (sectors + 1) создаётся один раз
+    2. sin/cos углов считаются заранее: по одной таблице на сектора и на слои
+    3. Нормаль - это (cos(stack) * cos(sector), cos(stack) * sin(sector), sin(stack)),
+       она уже единичная, sqrt не нужен
+    4. Треугольники задаются индексами (16 бит, если вершин не больше 65535)
+    */
     void generateSphere(float radius, int sectors, int stacks) {
-        std::vector<float> vertices;
-
-        float sectorStep = 2 * 3.14159265358979323846f / sectors;
-        float stackStep = 3.14159265358979323846f / stacks;
+        const float PI = 3.14159265358979323846f;
+        float sectorStep = 2 * PI / sectors;
+        float stackStep = PI / stacks;
+
+        // Таблицы sin/cos
+        std::vector<float> sectorCos(sectors + 1), sectorSin(sectors + 1);
+        for (int j = 0; j <= sectors; ++j) {
+            sectorCos[j] = cosf(j * sectorStep);
+            sectorSin[j] = sinf(j * sectorStep);
+        }
+        // Шов замыкаем точно, чтобы первая и последняя колонки совпадали
+        sectorCos[sectors] = sectorCos[0];
+        sectorSin[sectors] = sectorSin[0];
 
-        // Генерация вершин
+        std::vector<float> stackCos(stacks + 1), stackSin(stacks + 1);
         for (int i = 0; i <= stacks; ++i) {
-            float stackAngle = 3.14159265358979323846f / 2 - i * stackStep;
-            float xy = radius * cosf(stackAngle);
-            float z = radius * sinf(stackAngle);
+            float stackAngle = PI / 2 - i * stackStep;
+            stackCos[i] = cosf(stackAngle);
+            stackSin[i] = sinf(stackAngle);
+        }
 
+        // Вершины: позиция + нормаль
+        int vertexCount = (stacks + 1) * (sectors + 1);
+        std::vector<float> vertices(vertexCount * 6);
+        float* v = vertices.data();
+        for (int i = 0; i <= stacks; ++i) {
             for (int j = 0; j <= sectors; ++j) {
-                float sectorAngle = j * sectorStep;
+                float nx = stackCos[i] * sectorCos[j];
+                float ny = stackCos[i] * sectorSin[j];
+                float nz = stackSin[i];
+
+                *v++ = radius * nx;
+                *v++ = radius * ny;
+                *v++ = radius * nz;
+                *v++ = nx;
+                *v++ = ny;
+                *v++ = nz;
+            }
+        }
+
+        // Индексы: по 2 треугольника на квад, у полюсов по одному (второй вырожденный)
+        std::vector<unsigned int> indices;
+        indices.reserve((size_t)sectors * (stacks - 1) * 6);
+        for (int i = 0; i < stacks; ++i) {
+            unsigned int k1 = i * (sectors + 1);   // текущий слой
+            unsigned int k2 = k1 + sectors + 1;    // следующий слой
+
+            for (int j = 0; j < sectors; ++j, ++k1, ++k2) {
+                if (i != 0) {
+                    indices.push_back(k1);
+                    indices.push_back(k1 + 1);
+                    indices.push_back(k2);
+                }
+                if (i != stacks - 1) {
+                    indices.push_back(k2);
+                    indices.push_back(k1 + 1);
+                    indices.push_back(k2 + 1);
+                }
+            }
+        }
+        std::vector<PackedSphereVertex> packed;
+        const void* vertexData = vertices.data();
+        if (format == VertexFormat::Packed) {
+            packed = packVertices(vertices, vertexCount, radius);
+            vertexData = packed.data();
+        }
+
+        if (vertexCount <= 65536) {
+            std::vector<unsigned short> shortIndices(indices.begin(), indices.end());
+            upload(vertexData, vertexCount, shortIndices.data(), (int)shortIndices.size(),
+                GL_UNSIGNED_SHORT);
+        }
+        else {
+            upload(vertexData, vertexCount, indices.data(), (int)indices.size(),
+                GL_UNSIGNED_INT);
+        }
+    }
 
-                float x = xy * cosf(sectorAngle);
-                float y = xy * sinf(sectorAngle);
+    // Упаковка: позиция делится на радиус и квантуется в snorm16, нормаль - октаэдрически
+    std::vector<PackedSphereVertex> packVertices(const std::vector<float>& vertices,
+        int vertexCount, float radius) {
+        positionScale = radius;
+        float invScale = 1.0f / radius;
+
+        std::vector<PackedSphereVertex> packed(vertexCount);
+        for (int i = 0; i < vertexCount; ++i) {
+            const float* v = &vertices[i * 6];
+            PackedSphereVertex& p = packed[i];
+            p.position[0] = VertexPacking::toSnorm16(v[0] * invScale);
+            p.position[1] = VertexPacking::toSnorm16(v[1] * invScale);
+            p.position[2] = VertexPacking::toSnorm16(v[2] * invScale);
+            p.position[3] = 0;
+            VertexPacking::octEncode(v[3], v[4], v[5], p.normal[0], p.normal[1]);
+        }
+        return packed;
+    }
 
-                // Для каждой вершины создаем два треугольника
-                if (i < stacks && j < sectors) {
-                    // Первый треугольник текущего квада
-                    addVertex(x, y, z, vertices);
-                    addVertex(xy * cosf(sectorAngle + sectorStep),
-                        xy * sinf(sectorAngle + sectorStep), z, vertices);
+    // Загрузка вершин (позиция + нормаль) и индексов в OpenGL
+    void upload(const void* vertices, int vertexCount, const void* indices, int count, GLenum type) {
+        indexCount = count;
+        indexType = type;
+        size_t indexSize = (type == GL_UNSIGNED_SHORT) ? sizeof(unsigned short) : sizeof(unsigned int);
+        size_t vertexSize = (format == VertexFormat::Packed) ? sizeof(PackedSphereVertex) : 6 * sizeof(float);
 
-                    float nextStackAngle = 3.14159265358979323846f / 2 - (i + 1) * stackStep;
-                    float nextXY = radius * cosf(nextStackAngle);
-                    float nextZ = radius * sinf(nextStackAngle);
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
 
-                    addVertex(nextXY * cosf(sectorAngle),
-                        nextXY * sinf(sectorAngle), nextZ, vertices);
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, (size_t)vertexCount * vertexSize, vertices, GL_STATIC_DRAW);
 
-                    // Второй треугольник
-                    addVertex(nextXY * cosf(sectorAngle),
-                        nextXY * sinf(sectorAngle), nextZ, vertices);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, (size_t)count * indexSize, indices, GL_STATIC_DRAW);
 
-                    addVertex(xy * cosf(sectorAngle + sectorStep),
-                        xy * sinf(sectorAngle + sectorStep), z, vertices);
+        if (format == VertexFormat::Packed) {
+            // snorm16 -> [-1, 1] на стороне GPU (normalized = GL_TRUE)
+            glVertexAttribPointer(0, 3, GL_SHORT, GL_TRUE, sizeof(PackedSphereVertex),
+                (void*)offsetof(PackedSphereVertex, position));
+            glEnableVertexAttribArray(0);
 
-                    addVertex(nextXY * cosf(sectorAngle + sectorStep),
-                        nextXY * sinf(sectorAngle + sectorStep), nextZ, vertices);
-                }
-            }
+            glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, sizeof(PackedSphereVertex),
+                (void*)offsetof(PackedSphereVertex, normal));
+            glEnableVertexAttribArray(1);
+        }
+        else {
+            // Позиции (атрибут 0)
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+            glEnableVertexAttribArray(0);
+
+            // Нормали (атрибут 1)
+            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float),
+                (void*)(3 * sizeof(float)));
+            glEnableVertexAttribArray(1);
         }
 
-        vertexCount = vertices.size() / 6;  // 6 значений на вершину (позиция + нормаль)
+        // EBO остаётся привязанным к VAO
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+};
+
+// Икосфера единичного радиуса (подразделённый икосаэдр)
+// Треугольники почти одинаковые по всей поверхности, без сгущения у полюсов
+class IcosphereMesh {
+private:
+    unsigned int VAO, VBO, EBO;
+    int indexCount;
+
+public:
+    // Уровень 6 даёт 40962 вершины - максимум для 16-битных индексов
+    static const int MAX_LEVEL = 6;
+
+    explicit IcosphereMesh(int level) {
+        generate(std::min(std::max(level, 0), MAX_LEVEL));
+    }
+
+    ~IcosphereMesh() {
+        glDeleteVertexArrays(1, &VAO);
+        glDeleteBuffers(1, &VBO);
+        glDeleteBuffers(1, &EBO);
+    }
+
+    IcosphereMesh(const IcosphereMesh&) = delete;
+    IcosphereMesh& operator=(const IcosphereMesh&) = delete;
+
+    int getTriangleCount() const { return indexCount / 3; }
+
+    void render() const {
+        glBindVertexArray(VAO);
+        glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_SHORT, 0);
+        glBindVertexArray(0);
+    }
+
+private:
+    /*
+    Генерация:
+    1. Начинаем с 12 вершин и 20 граней икосаэдра
+    2. На каждом уровне каждый треугольник делится на 4,
+       середины рёбер проецируются на сферу
+    3. Середина общего ребра создаётся один раз (кэш по паре индексов)
+    Вершин на уровне L: 10 * 4^L + 2, треугольников: 20 * 4^L
+    */
+    void generate(int level) {
+        const float t = (1.0f + sqrtf(5.0f)) / 2.0f;
+        const float s = 1.0f / sqrtf(1.0f + t * t);
+
+        size_t finalVertices = 10 * ((size_t)1 << (2 * level)) + 2;
+        size_t finalIndices = 60 * ((size_t)1 << (2 * level));
+
+        std::vector<float> positions = {
+            -s,  t * s, 0,   s,  t * s, 0,   -s, -t * s, 0,   s, -t * s, 0,
+            0, -s,  t * s,   0,  s,  t * s,   0, -s, -t * s,   0,  s, -t * s,
+             t * s, 0, -s,   t * s, 0,  s,   -t * s, 0, -s,   -t * s, 0,  s
+        };
+        positions.reserve(finalVertices * 3);
+
+        std::vector<unsigned short> indices = {
+            0, 11, 5,   0, 5, 1,    0, 1, 7,    0, 7, 10,   0, 10, 11,
+            1, 5, 9,    5, 11, 4,   11, 10, 2,  10, 7, 6,   7, 1, 8,
+            3, 9, 4,    3, 4, 2,    3, 2, 6,    3, 6, 8,    3, 8, 9,
+            4, 9, 5,    2, 4, 11,   6, 2, 10,   8, 6, 7,    9, 8, 1
+        };
+
+        std::unordered_map<unsigned int, unsigned short> midpoints;
+        midpoints.reserve(finalVertices);
+
+        auto midpoint = [&](unsigned short a, unsigned short b) -> unsigned short {
+            unsigned int key = a < b ? ((unsigned int)a << 16 | b) : ((unsigned int)b << 16 | a);
+            auto it = midpoints.find(key);
+            if (it != midpoints.end()) return it->second;
+
+            float x = positions[a * 3] + positions[b * 3];
+            float y = positions[a * 3 + 1] + positions[b * 3 + 1];
+            float z = positions[a * 3 + 2] + positions[b * 3 + 2];
+            float invLen = 1.0f / sqrtf(x * x + y * y + z * z);
+
+            unsigned short index = (unsigned short)(positions.size() / 3);
+            positions.push_back(x * invLen);
+            positions.push_back(y * invLen);
+            positions.push_back(z * invLen);
+            midpoints[key] = index;
+            return index;
+            };
+
+        std::vector<unsigned short> next;
+        next.reserve(finalIndices);
+        for (int l = 0; l < level; l++) {
+            next.clear();
+            for (size_t i = 0; i < indices.size(); i += 3) {
+                unsigned short a = indices[i], b = indices[i + 1], c = indices[i + 2];
+                unsigned short ab = midpoint(a, b);
+                unsigned short bc = midpoint(b, c);
+                unsigned short ca = midpoint(c, a);
+
+                unsigned short tris[12] = { a, ab, ca,  b, bc, ab,  c, ca, bc,  ab, bc, ca };
+                next.insert(next.end(), tris, tris + 12);
+            }
+            indices.swap(next);
+            midpoints.clear();
+        }
+        indexCount = (int)indices.size();
 
-        // Создание OpenGL объектов
         glGenVertexArrays(1, &VAO);
         glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
 
         glBindVertexArray(VAO);
         glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float),
-            vertices.data(), GL_STATIC_DRAW);
+        glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(float),
+            positions.data(), GL_STATIC_DRAW);
 
-        // Позиции (атрибут 0)
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-        glEnableVertexAttribArray(0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned short),
+            indices.data(), GL_STATIC_DRAW);
 
-        // Нормали (атрибут 1)
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float),
-            (void*)(3 * sizeof(float)));
+        // У единичной сферы нормаль совпадает с позицией:
+        // оба атрибута читают одни и те же 3 float
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
         glEnableVertexAttribArray(1);
 
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
         glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+};
+
+// Кэш уровней детализации икосферы
+// Каждый уровень создаётся один раз при первом запросе и общий для всех сфер
+class IcosphereLODCache {
+private:
+    std::unique_ptr<IcosphereMesh> levels[IcosphereMesh::MAX_LEVEL + 1];
+    float targetEdgePixels;
+
+public:
+    // targetEdgePixels - желаемая длина ребра треугольника на экране
+    explicit IcosphereLODCache(float targetEdgePixels = 8.0f)
+        : targetEdgePixels(targetEdgePixels) {
+    }
+
+    const IcosphereMesh& getLevel(int level) {
+        level = std::min(std::max(level, 0), (int)IcosphereMesh::MAX_LEVEL);
+        if (!levels[level]) {
+            levels[level].reset(new IcosphereMesh(level));
+        }
+        return *levels[level];
+    }
+
+    /*
+    Выбор уровня по экранному размеру:
+    радиус на экране (пиксели) = radius / (distance * tan(fov / 2)) * viewportHeight / 2,
+    ребро уровня L на единичной сфере ~ 1.05 / 2^L,
+    берём наименьший L, при котором ребро на экране не длиннее targetEdgePixels.
+    */
+    int selectLevel(float radius, float distance, float fovY, int viewportHeight) const {
+        if (distance <= radius) return IcosphereMesh::MAX_LEVEL;
+
+        float projected = radius / (distance * tanf(fovY / 2.0f)) * viewportHeight * 0.5f;
+        float edge = projected * 1.05f / targetEdgePixels;
+        if (edge <= 1.0f) return 0;
+
+        int level = (int)ceilf(log2f(edge));
+        return std::min(level, (int)IcosphereMesh::MAX_LEVEL);
+    }
+
+    void render(float radius, float distance, float fovY, int viewportHeight) {
+        getLevel(selectLevel(radius, distance, fovY, viewportHeight)).render();
+    }
+};
+
+// Данные одного экземпляра сферы (атрибуты 2 и 3)
+struct SphereInstance {
+    float position[3];
+    float radius;
+    float color[4];
+};
+
+/*
+Кольцевой буфер экземпляров:
+1. Буфер разбит на REGIONS областей по capacity экземпляров
+2. Каждый кадр пишем в следующую область, пока GPU читает предыдущие
+3. После отрисовки ставим fence; перед повторной записью в область ждём его
+   (при трёх областях ожидание почти никогда не блокирует)
+Если доступен ARB_buffer_storage, буфер отображается один раз навсегда
+(persistent + coherent). Иначе каждая область отображается на кадр
+через glMapBufferRange с GL_MAP_UNSYNCHRONIZED_BIT - синхронизация та же, на fence.
+*/
+class SphereInstanceRing {
+private:
+    static const int REGIONS = 3;
+
+    unsigned int buffer;
+    size_t capacity;
+    bool persistent;
+    char* mapped;               // весь буфер (persistent) или текущая область
+    GLsync fences[REGIONS];
+    int region;
+
+    size_t regionBytes() const { return capacity * sizeof(SphereInstance); }
+
+public:
+    explicit SphereInstanceRing(size_t capacity)
+        : capacity(capacity), mapped(nullptr), region(0) {
+        for (int i = 0; i < REGIONS; i++) fences[i] = 0;
+
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+
+        persistent = GLEW_ARB_buffer_storage;
+        if (persistent) {
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            glBufferStorage(GL_ARRAY_BUFFER, regionBytes() * REGIONS, NULL, flags);
+            mapped = (char*)glMapBufferRange(GL_ARRAY_BUFFER, 0, regionBytes() * REGIONS, flags);
+        }
+        else {
+            glBufferData(GL_ARRAY_BUFFER, regionBytes() * REGIONS, NULL, GL_STREAM_DRAW);
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    ~SphereInstanceRing() {
+        for (int i = 0; i < REGIONS; i++) {
+            if (fences[i]) glDeleteSync(fences[i]);
+        }
+        if (persistent) {
+            glBindBuffer(GL_ARRAY_BUFFER, buffer);
+            glUnmapBuffer(GL_ARRAY_BUFFER);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+        }
+        glDeleteBuffers(1, &buffer);
+    }
+
+    SphereInstanceRing(const SphereInstanceRing&) = delete;
+    SphereInstanceRing& operator=(const SphereInstanceRing&) = delete;
+
+    size_t getCapacity() const { return capacity; }
+
+    // Получить область для записи экземпляров текущего кадра (не больше getCapacity())
+    SphereInstance* beginFrame() {
+        region = (region + 1) % REGIONS;
+
+        // Ждём, пока GPU закончит читать эту область
+        if (fences[region]) {
+            GLenum result;
+            do {
+                result = glClientWaitSync(fences[region], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+            } while (result == GL_TIMEOUT_EXPIRED);
+            glDeleteSync(fences[region]);
+            fences[region] = 0;
+        }
+
+        if (persistent) {
+            return (SphereInstance*)(mapped + region * regionBytes());
+        }
+
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        mapped = (char*)glMapBufferRange(GL_ARRAY_BUFFER, region * regionBytes(), regionBytes(),
+            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        return (SphereInstance*)mapped;
+    }
+
+    // Нарисовать count экземпляров общего меша одним вызовом
+    void draw(Sphere& mesh, size_t count) {
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        if (!persistent) {
+            glUnmapBuffer(GL_ARRAY_BUFFER);
+        }
+
+        // Атрибуты экземпляров указывают на текущую область кольца
+        size_t base = region * regionBytes();
+        glBindVertexArray(mesh.getVAO());
+        glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(SphereInstance),
+            (void*)(base + offsetof(SphereInstance, position)));
+        glEnableVertexAttribArray(2);
+        glVertexAttribDivisor(2, 1);
+
+        glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(SphereInstance),
+            (void*)(base + offsetof(SphereInstance, color)));
+        glEnableVertexAttribArray(3);
+        glVertexAttribDivisor(3, 1);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        mesh.renderInstanced((int)std::min(count, capacity));
+
+        fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+};
+
+// Данные блока Camera в раскладке std140 (vec3 дополняется до vec4)
+struct CameraBlock {
+    float view[16];
+    float projection[16];
+    float viewPos[4];
+    float lightPos[4];
+    float lightColor[4];
+};
+
+// Uniform-буфер камеры: общий для всех программ, обновляется один раз за кадр
+class CameraUniformBuffer {
+private:
+    unsigned int UBO;
+
+public:
+    // Точка привязки, к которой Shader подключает блок Camera
+    static const unsigned int BINDING = 0;
+
+    CameraUniformBuffer() {
+        glGenBuffers(1, &UBO);
+        glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(CameraBlock), NULL, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        glBindBufferBase(GL_UNIFORM_BUFFER, BINDING, UBO);
     }
 
-    void addVertex(float x, float y, float z, std::vector<float>& vertices) {
-        // Позиция
-        vertices.push_back(x);
-        vertices.push_back(y);
-        vertices.push_back(z);
+    ~CameraUniformBuffer() {
+        glDeleteBuffers(1, &UBO);
+    }
 
-        // Нормаль (нормализованная позиция)
-        float length = sqrt(x * x + y * y + z * z);
-        vertices.push_back(x / length);
-        vertices.push_back(y / length);
-        vertices.push_back(z / length);
+    void update(const CameraBlock& block) {
+        glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(CameraBlock), &block);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
     }
 };
 
+// Типизированные дескрипторы uniform-переменных (location из кэша шейдера)
+struct UniformMat4 { int location = -1; };
+struct UniformVec3 { int location = -1; };
+struct UniformInt { int location = -1; };
+
 // Класс для работы с шейдерами
 class Shader {
 private:
     unsigned int ID;
+    // Имя -> location, заполняется один раз после линковки
+    std::unordered_map<std::string, int> locations;
 
 public:
     Shader(const char* vertexSource, const char* fragmentSource) {
         compileShader(vertexSource, fragmentSource);
+        cacheUniforms();
     }
 
     void use() {
         glUseProgram(ID);
     }
 
+    // Поиск дескрипторов (делается один раз, вне цикла рендеринга)
+    UniformMat4 getMat4(const char* name) const { return { findLocation(name) }; }
+    UniformVec3 getVec3(const char* name) const { return { findLocation(name) }; }
+    UniformInt getInt(const char* name) const { return { findLocation(name) }; }
+
+    void set(UniformMat4 uniform, const float* mat) const {
+        glUniformMatrix4fv(uniform.location, 1, GL_FALSE, mat);
+    }
+
+    void set(UniformVec3 uniform, float x, float y, float z) const {
+        glUniform3f(uniform.location, x, y, z);
+    }
+
+    void set(UniformInt uniform, int value) const {
+        glUniform1i(uniform.location, value);
+    }
+
+    // Установка по имени (через кэш, без glGetUniformLocation)
     void setMat4(const char* name, const float* mat) const {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name), 1, GL_FALSE, mat);
+        set(getMat4(name), mat);
+    }
+
+    void setInt(const char* name, int value) const {
+        set(getInt(name), value);
     }
 
     void setVec3(const char* name, float x, float y, float z) const {
-        glUniform3f(glGetUniformLocation(ID, name), x, y, z);
+        set(getVec3(name), x, y, z);
     }
 
 private:
+    int findLocation(const char* name) const {
+        auto it = locations.find(name);
+        return it != locations.end() ? it->second : -1;
+    }
+
     void compileShader(const char* vertexSource, const char* fragmentSource) {
         // Компиляция вершинного шейдера
         unsigned int vertexShader = glCreateShader(GL_VERTEX_SHADER);
@@ -292,47 +870,113 @@ private:
         glDeleteShader(vertexShader);
         glDeleteShader(fragmentShader);
     }
-};
 
-int main() {
-    // Инициализация GLFW
-    if (!glfwInit()) {
-        std::cerr << "Failed to initialize GLFW" << std::endl;
-        return -1;
+    // Перебор активных uniform-переменных и привязка блока Camera
+    void cacheUniforms() {
+        int count = 0;
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+
+        char name[256];
+        for (int i = 0; i < count; i++) {
+            int length = 0, size = 0;
+            GLenum type;
+            glGetActiveUniform(ID, i, sizeof(name), &length, &size, &type, name);
+
+            // Переменные блоков не имеют location
+            int location = glGetUniformLocation(ID, name);
+            if (location < 0) continue;
+
+            std::string key(name, length);
+            // Массивы приходят как "name[0]"
+            if (key.size() > 3 && key.compare(key.size() - 3, 3, "[0]") == 0) {
+                key.resize(key.size() - 3);
+            }
+            locations[key] = location;
+        }
+
+        unsigned int blockIndex = glGetUniformBlockIndex(ID, "Camera");
+        if (blockIndex != GL_INVALID_INDEX) {
+            glUniformBlockBinding(ID, blockIndex, CameraUniformBuffer::BINDING);
+        }
     }
+};
 
-    // Настройка GLFW
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+int main(int argc, char** argv) {
+    // --headless: без окна, рисование во внеэкранный буфер заданное число кадров
+    Headless::Options headless = Headless::parseArgs(argc, argv, 800, 600);
+    Headless::Context offscreen;
+    GLFWwindow* window = nullptr;
 
-    // Создание окна
-    GLFWwindow* window = glfwCreateWindow(800, 600, "3D Sphere without GLM", NULL, NULL);
-    if (!window) {
-        std::cerr << "Failed to create GLFW window" << std::endl;
-        glfwTerminate();
-        return -1;
+    if (headless.enabled) {
+        if (!offscreen.create(headless)) return -1;
     }
+    else {
+        // Инициализация GLFW
+        if (!glfwInit()) {
+            std::cerr << "Failed to initialize GLFW" << std::endl;
+            return -1;
+        }
 
-    glfwMakeContextCurrent(window);
+        // Настройка GLFW
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+        // Создание окна
+        window = glfwCreateWindow(800, 600, "3D Sphere without GLM", NULL, NULL);
+        if (!window) {
+            std::cerr << "Failed to create GLFW window" << std::endl;
+            glfwTerminate();
+            return -1;
+        }
 
-    // Инициализация GLEW
-    if (glewInit() != GLEW_OK) {
-        std::cerr << "Failed to initialize GLEW" << std::endl;
-        return -1;
+        glfwMakeContextCurrent(window);
+
+        // Инициализация GLEW
+        if (glewInit() != GLEW_OK) {
+            std::cerr << "Failed to initialize GLEW" << std::endl;
+            return -1;
+        }
     }
 
     // Настройка OpenGL
     glEnable(GL_DEPTH_TEST);
 
-    // Создание шейдера
+    // Создание шейдера и поиск uniform-переменных (один раз)
     Shader shader(vertexShaderSource, fragmentShaderSource);
+    UniformMat4 modelUniform = shader.getMat4("model");
+    UniformVec3 objectColorUniform = shader.getVec3("objectColor");
+    UniformInt octNormalsUniform = shader.getInt("octNormals");
+
+    // Программа для отрисовки экземпляров
+    Shader instancedShader(instancedVertexShaderSource, instancedFragmentShaderSource);
 
-    // Создание сферы
-    Sphere sphere(1.0f, 32, 16);
+    // Поле из 300 x 300 маленьких сфер: один общий меш, один вызов отрисовки.
+    // Большая часть поля вне экрана - перед отрисовкой сферы отсекаются по пирамиде видимости.
+    const int FIELD_SIZE = 300;
+    Sphere instanceMesh(1.0f, 16, 8);
+    SphereInstanceRing instanceRing(FIELD_SIZE * FIELD_SIZE);
+    FrustumCulling::BoundingSpheres fieldBounds;
+    fieldBounds.resize(FIELD_SIZE * FIELD_SIZE);
+    std::vector<uint32_t> visibleInstances;
+
+    // Камера и свет - в общем uniform-буфере
+    CameraUniformBuffer cameraBuffer;
+    CameraBlock camera = {};
+
+    // Создание сферы (меш 32x16 построен при компиляции)
+    using SphereMesh32x16 = StaticMesh::SphereMesh<32, 16>;
+    Sphere sphere(SphereMesh32x16::vertices.data(), SphereMesh32x16::VERTEX_COUNT,
+        SphereMesh32x16::indices.data(), SphereMesh32x16::INDEX_COUNT);
+
+    // Плотная сфера в упакованном формате (12 байт на вершину вместо 24)
+    Sphere packedSphere(0.5f, 128, 64, VertexFormat::Packed);
+
+    // Икосферы с выбором детализации по расстоянию
+    IcosphereLODCache icospheres;
 
     // Основной цикл
-    while (!glfwWindowShouldClose(window)) {
+    while (headless.enabled ? offscreen.nextFrame() : !glfwWindowShouldClose(window)) {
         // Очистка буферов
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -349,7 +993,7 @@ int main() {
         glm::mat4 projection = glm::mat4(1.0f);
 
         // Вращение
-        float time = glfwGetTime();
+        float time = headless.enabled ? offscreen.getTime() : glfwGetTime();
         model = glm::rotate(model, time * 0.5f, glm::vec3(0.5f, 1.0f, 0.0f));
 
         // Камера
@@ -357,61 +1001,142 @@ int main() {
 
         // Проекция
         int width, height;
-        glfwGetWindowSize(window, &width, &height);
+        if (headless.enabled) {
+            width = offscreen.getWidth();
+            height = offscreen.getHeight();
+        }
+        else {
+            glfwGetWindowSize(window, &width, &height);
+        }
         float aspect = (float)width / (float)height;
         projection = glm::perspective(glm::radians(45.0f), aspect, 0.1f, 100.0f);
 
         // Передача матриц
-        shader.setMat4("model", glm::value_ptr(model));
-        shader.setMat4("view", glm::value_ptr(view));
-        shader.setMat4("projection", glm::value_ptr(projection));
+        shader.set(modelUniform, glm::value_ptr(model));
+        std::memcpy(camera.view, glm::value_ptr(view), sizeof(camera.view));
+        std::memcpy(camera.projection, glm::value_ptr(projection), sizeof(camera.projection));
 
         // ============================================
         // ВАРИАНТ 2: Без GLM (используем SimpleMath)
         // ============================================
 #else
-        float time = glfwGetTime();
+        float time = headless.enabled ? offscreen.getTime() : glfwGetTime();
 
         // Матрица модели (вращение вокруг оси Y)
         float modelMatrix[16];
         SimpleMath::createRotationYMatrix(time * 0.5f, modelMatrix);
 
         // Матрица вида (камера отодвинута назад)
-        float viewMatrix[16];
-        SimpleMath::createTranslationMatrix(0.0f, 0.0f, -3.0f, viewMatrix);
+        SimpleMath::createTranslationMatrix(0.0f, 0.0f, -3.0f, camera.view);
 
         // Матрица проекции
-        float projectionMatrix[16];
         int width, height;
-        glfwGetWindowSize(window, &width, &height);
+        if (headless.enabled) {
+            width = offscreen.getWidth();
+            height = offscreen.getHeight();
+        }
+        else {
+            glfwGetWindowSize(window, &width, &height);
+        }
         float aspect = (float)width / (float)height;
         SimpleMath::createPerspectiveMatrix(SimpleMath::toRadians(45.0f),
             aspect, 0.1f, 100.0f,
-            projectionMatrix);
+            camera.projection);
 
-        // Передача матриц в шейдер
-        shader.setMat4("model", modelMatrix);
-        shader.setMat4("view", viewMatrix);
-        shader.setMat4("projection", projectionMatrix);
+        // Передача матрицы модели в шейдер
+        shader.set(modelUniform, modelMatrix);
 #endif
 
         // Параметры освещения
-        shader.setVec3("lightPos", 2.0f, 2.0f, 2.0f);
-        shader.setVec3("viewPos", 0.0f, 0.0f, 3.0f);
-        shader.setVec3("lightColor", 1.0f, 1.0f, 1.0f);
-        shader.setVec3("objectColor", 0.5f, 0.3f, 0.8f);
+        float lightPos[4] = { 2.0f, 2.0f, 2.0f, 1.0f };
+        float viewPos[4] = { 0.0f, 0.0f, 3.0f, 1.0f };
+        float lightColor[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+        std::memcpy(camera.lightPos, lightPos, sizeof(lightPos));
+        std::memcpy(camera.viewPos, viewPos, sizeof(viewPos));
+        std::memcpy(camera.lightColor, lightColor, sizeof(lightColor));
+
+        // Один раз за кадр для всех программ
+        cameraBuffer.update(camera);
+
+        shader.set(objectColorUniform, 0.5f, 0.3f, 0.8f);
 
         // Отрисовка сферы
         sphere.render();
 
+        // Упакованная сфера слева: масштаб позиций переносится в матрицу модели
+        float packedModel[16];
+        SimpleMath::createTranslationMatrix(-2.0f, 0.0f, 0.0f, packedModel);
+        packedModel[0] = packedModel[5] = packedModel[10] = packedSphere.getPositionScale();
+        shader.set(modelUniform, packedModel);
+        shader.set(octNormalsUniform, 1);
+        packedSphere.render();
+        shader.set(octNormalsUniform, 0);
+
+        // Ряд икосфер, уходящий вдаль: чем дальше сфера, тем грубее уровень
+        for (int k = 0; k < 8; k++) {
+            float radius = 0.3f;
+            float x = 1.5f, z = -4.0f * k;
+
+            float icoModel[16];
+            SimpleMath::createTranslationMatrix(x, 0.0f, z, icoModel);
+            icoModel[0] = icoModel[5] = icoModel[10] = radius;
+            shader.set(modelUniform, icoModel);
+
+            // Камера находится в (0, 0, 3)
+            float distance = sqrtf(x * x + (3.0f - z) * (3.0f - z));
+            icospheres.render(radius, distance, SimpleMath::toRadians(45.0f), height);
+        }
+
+        // Поле сфер-экземпляров: сначала ограничивающие сферы (SoA)
+        for (int i = 0; i < FIELD_SIZE; i++) {
+            for (int j = 0; j < FIELD_SIZE; j++) {
+                float x = -30.0f + i * 0.2f;
+                float z = -2.0f - j * 0.2f;
+                float wave = sinf(time * 2.0f + x * 0.5f + z * 0.5f);
+                fieldBounds.set(i * FIELD_SIZE + j, x, -2.0f + 0.2f * wave, z, 0.06f + 0.02f * wave);
+            }
+        }
+
+        // Отсечение по пирамиде projection * view (радиус меша = 1, поэтому сфера = экземпляр)
+        float viewProjection[16];
+        MatrixSIMD::multiply(camera.projection, camera.view, viewProjection);
+        FrustumCulling::Frustum frustum = FrustumCulling::extractFrustum(viewProjection);
+        size_t visibleCount = FrustumCulling::cullSpheres(frustum, fieldBounds, visibleInstances);
+
+        // В отображённый буфер пишутся только видимые экземпляры
+        SphereInstance* instances = instanceRing.beginFrame();
+        for (size_t k = 0; k < visibleCount; k++) {
+            uint32_t id = visibleInstances[k];
+            SphereInstance& inst = instances[k];
+            float wave = (fieldBounds.y[id] + 2.0f) * 5.0f;
+
+            inst.position[0] = fieldBounds.x[id];
+            inst.position[1] = fieldBounds.y[id];
+            inst.position[2] = fieldBounds.z[id];
+            inst.radius = fieldBounds.r[id];
+            inst.color[0] = 0.5f + 0.5f * wave;
+            inst.color[1] = 0.4f;
+            inst.color[2] = 0.5f - 0.5f * wave;
+            inst.color[3] = 1.0f;
+        }
+        instancedShader.use();
+        instanceRing.draw(instanceMesh, visibleCount);
+
         // Обновление окна
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        if (!headless.enabled) {
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+        }
     }
 
     // Очистка
-    glfwDestroyWindow(window);
-    glfwTerminate();
+    if (headless.enabled) {
+        offscreen.finish();
+    }
+    else {
+        glfwDestroyWindow(window);
+        glfwTerminate();
+    }
 
     return 0;
 }
\ No newline at end of file
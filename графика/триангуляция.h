@@ -0,0 +1,458 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <set>
+#include <unordered_map>
+#include <vector>
+#include <algorithm>
+
+// ============================================
+// Триангуляция многоугольников с дырами (разбиение на монотонные части)
+// ============================================
+
+// Контуры задаются парами (x, y): первый - внешний, остальные - дыры. Направление
+// обхода любое, контуры не должны пересекаться. Результат - индексы треугольников
+// (против часовой стрелки) в общий массив точек всех контуров подряд.
+// Сложность O(n log n): заметающая прямая делит многоугольник диагоналями на
+// y-монотонные части, каждая часть триангулируется за линейное время.
+// Cache запоминает результат по хэшу контуров - неизменившаяся фигура не
+// триангулируется повторно.
+
+namespace Triangulation {
+
+typedef std::vector<std::vector<float>> Rings;
+
+struct Mesh {
+    std::vector<float> points;        // все контуры подряд, пары (x, y)
+    std::vector<size_t> ringSizes;    // число точек в каждом контуре
+    std::vector<uint32_t> indices;    // по три на треугольник
+    bool complete = false;            // false - контуры вырождены, треугольников нет
+};
+
+namespace Detail {
+
+struct Point {
+    float x, y;
+};
+
+// Порядок заметания: сверху вниз, при равной высоте - справа налево
+inline bool below(const Point& a, const Point& b) {
+    return a.y < b.y || (a.y == b.y && a.x < b.x);
+}
+
+// c слева от направленной прямой a -> b
+inline bool leftTurn(const Point& a, const Point& b, const Point& c) {
+    return (double)(b.x - a.x) * (c.y - a.y) - (double)(b.y - a.y) * (c.x - a.x) > 0.0;
+}
+
+enum class VertexType : uint8_t { Start, End, Split, Merge, Regular };
+
+struct Vertex {
+    Point p;
+    uint32_t source;     // индекс точки во входных данных (копии от диагоналей его сохраняют)
+    uint32_t previous, next;
+};
+
+// Ребро vertex -> next в дереве заметания; слева направо по x на текущей высоте
+struct SweepEdge {
+    Point p1, p2;
+    mutable uint32_t vertex;
+
+    bool operator<(const SweepEdge& other) const {
+        if (other.p1.y == other.p2.y) {
+            if (p1.y == p2.y) return p1.y < other.p1.y;
+            return leftTurn(p1, p2, other.p1);
+        }
+        if (p1.y == p2.y || p1.y < other.p1.y) return !leftTurn(other.p1, other.p2, p1);
+        return leftTurn(p1, p2, other.p1);
+    }
+};
+
+typedef std::multiset<SweepEdge>::iterator EdgeIterator;
+
+struct Partition {
+    std::vector<Vertex> vertices;
+    std::vector<VertexType> types;
+    std::vector<EdgeIterator> edges;     // ребро, начинающееся в вершине (или end())
+    std::vector<uint32_t> helpers;
+    std::multiset<SweepEdge> tree;
+
+    /*
+    Диагональ a - b: обе вершины раздваиваются, и один контур распадается на два.
+    Копии a2, b2 продолжают старые рёбра a -> next(a), b -> next(b),
+    поэтому ребро дерева и helper переходят к копиям.
+    */
+    uint32_t addDiagonal(uint32_t a, uint32_t b) {
+        uint32_t a2 = (uint32_t)vertices.size();
+        uint32_t b2 = a2 + 1;
+        vertices.push_back(vertices[a]);
+        vertices.push_back(vertices[b]);
+        types.push_back(types[a]);
+        types.push_back(types[b]);
+        edges.push_back(edges[a]);
+        edges.push_back(edges[b]);
+        helpers.push_back(helpers[a]);
+        helpers.push_back(helpers[b]);
+
+        vertices[vertices[a].next].previous = a2;
+        vertices[vertices[b].next].previous = b2;
+        vertices[a].next = b2;
+        vertices[b2].previous = a;
+        vertices[b].next = a2;
+        vertices[a2].previous = b;
+
+        if (edges[a2] != tree.end()) edges[a2]->vertex = a2;
+        if (edges[b2] != tree.end()) edges[b2]->vertex = b2;
+        edges[a] = tree.end();
+        edges[b] = tree.end();
+        return a2;
+    }
+
+    void insertEdge(uint32_t v, uint32_t helper) {
+        edges[v] = tree.insert({ vertices[v].p, vertices[vertices[v].next].p, v });
+        helpers[v] = helper;
+    }
+
+    bool removeEdge(uint32_t v) {
+        if (edges[v] == tree.end()) return false;
+        tree.erase(edges[v]);
+        edges[v] = tree.end();
+        return true;
+    }
+
+    // Ребро дерева непосредственно слева от вершины
+    bool edgeLeftOf(uint32_t v, EdgeIterator& result) {
+        EdgeIterator it = tree.lower_bound({ vertices[v].p, vertices[v].p, v });
+        if (it == tree.begin()) return false;
+        result = --it;
+        return true;
+    }
+
+    bool helperIsMerge(uint32_t edgeVertex) const { return types[helpers[edgeVertex]] == VertexType::Merge; }
+};
+
+/*
+Разбиение на монотонные части (заметающая прямая сверху вниз):
+1. Тип вершины по соседям: оба ниже - начало (выпуклая) или раздвоение,
+   оба выше - конец (выпуклая) или слияние, иначе обычная
+2. В дереве - рёбра, справа от которых внутренность; у каждого "помощник" -
+   последняя вершина между ним и правым соседом
+3. Раздвоение соединяется диагональю с помощником ребра слева, слияние -
+   со следующей вершиной, которая станет помощником того же ребра
+После этого ни у одной части нет раздвоений и слияний - все y-монотонны.
+*/
+inline bool partition(Partition& part) {
+    size_t n = part.vertices.size();
+    part.types.resize(n);
+    part.helpers.assign(n, 0);
+    part.edges.assign(n, part.tree.end());
+    part.vertices.reserve(n * 3);
+    part.types.reserve(n * 3);
+    part.helpers.reserve(n * 3);
+    part.edges.reserve(n * 3);
+
+    std::vector<uint32_t> order(n);
+    for (size_t i = 0; i < n; i++) {
+        order[i] = (uint32_t)i;
+        const Vertex& v = part.vertices[i];
+        const Point& prev = part.vertices[v.previous].p;
+        const Point& next = part.vertices[v.next].p;
+        bool convex = leftTurn(next, prev, v.p);
+        if (below(prev, v.p) && below(next, v.p)) part.types[i] = convex ? VertexType::Start : VertexType::Split;
+        else if (below(v.p, prev) && below(v.p, next)) part.types[i] = convex ? VertexType::End : VertexType::Merge;
+        else part.types[i] = VertexType::Regular;
+    }
+    std::sort(order.begin(), order.end(), [&part](uint32_t a, uint32_t b) {
+        return below(part.vertices[b].p, part.vertices[a].p);
+    });
+
+    for (uint32_t v : order) {
+        uint32_t previous = part.vertices[v].previous;
+        EdgeIterator left;
+        switch (part.types[v]) {
+        case VertexType::Start:
+            part.insertEdge(v, v);
+            break;
+
+        case VertexType::End:
+            if (part.edges[previous] == part.tree.end()) return false;
+            if (part.helperIsMerge(previous)) part.addDiagonal(v, part.helpers[previous]);
+            part.removeEdge(previous);
+            break;
+
+        case VertexType::Split: {
+            if (!part.edgeLeftOf(v, left)) return false;
+            uint32_t v2 = part.addDiagonal(v, part.helpers[left->vertex]);
+            part.helpers[left->vertex] = v;
+            part.insertEdge(v2, v2);
+            break;
+        }
+
+        case VertexType::Merge: {
+            if (part.edges[previous] == part.tree.end()) return false;
+            uint32_t v2 = v;
+            if (part.helperIsMerge(previous)) v2 = part.addDiagonal(v, part.helpers[previous]);
+            part.removeEdge(previous);
+            if (!part.edgeLeftOf(v, left)) return false;
+            if (part.helperIsMerge(left->vertex)) part.addDiagonal(v2, part.helpers[left->vertex]);
+            part.helpers[left->vertex] = v2;
+            break;
+        }
+
+        case VertexType::Regular:
+            // Контур идёт вниз - внутренность справа, вершина продолжает левую границу
+            if (below(part.vertices[v].p, part.vertices[previous].p)) {
+                if (part.edges[previous] == part.tree.end()) return false;
+                uint32_t v2 = v;
+                if (part.helperIsMerge(previous)) v2 = part.addDiagonal(v, part.helpers[previous]);
+                part.removeEdge(previous);
+                part.insertEdge(v2, v2);
+            }
+            else {
+                if (!part.edgeLeftOf(v, left)) return false;
+                if (part.helperIsMerge(left->vertex)) part.addDiagonal(v, part.helpers[left->vertex]);
+                part.helpers[left->vertex] = v;
+            }
+            break;
+        }
+    }
+    return true;
+}
+
+/*
+Триангуляция y-монотонного многоугольника (points против часовой стрелки):
+1. Левая и правая цепи сливаются в один список сверху вниз
+2. Вершины идут через стек: вершина с другой цепи видит весь стек - веер
+   треугольников; с той же цепи - отрезаются треугольники, пока угол выпуклый
+*/
+inline bool triangulateMonotone(const std::vector<Point>& points, const std::vector<uint32_t>& sources,
+    std::vector<uint32_t>& indices) {
+    size_t n = points.size();
+    if (n < 3) return true;
+    auto emit = [&](size_t a, size_t b, size_t c) {
+        indices.push_back(sources[a]);
+        indices.push_back(sources[b]);
+        indices.push_back(sources[c]);
+    };
+    if (n == 3) {
+        emit(0, 1, 2);
+        return true;
+    }
+
+    size_t top = 0, bottom = 0;
+    for (size_t i = 1; i < n; i++) {
+        if (below(points[i], points[bottom])) bottom = i;
+        if (below(points[top], points[i])) top = i;
+    }
+    for (size_t i = top; i != bottom; i = (i + 1) % n) {
+        if (!below(points[(i + 1) % n], points[i])) return false;
+    }
+    for (size_t i = bottom; i != top; i = (i + 1) % n) {
+        if (!below(points[i], points[(i + 1) % n])) return false;
+    }
+
+    // side: 1 - левая цепь (вперёд от верхней), -1 - правая, 0 - верх и низ
+    std::vector<int8_t> side(n);
+    std::vector<size_t> order(n);
+    order[0] = top;
+    side[top] = 0;
+    size_t left = (top + 1) % n, right = (top + n - 1) % n;
+    size_t k = 1;
+    for (; k < n - 1; k++) {
+        bool takeRight = left == bottom || (right != bottom && below(points[left], points[right]));
+        if (takeRight) {
+            order[k] = right;
+            side[right] = -1;
+            right = (right + n - 1) % n;
+        }
+        else {
+            order[k] = left;
+            side[left] = 1;
+            left = (left + 1) % n;
+        }
+    }
+    order[k] = bottom;
+    side[bottom] = 0;
+
+    std::vector<size_t> stack;
+    stack.reserve(n);
+    stack.push_back(order[0]);
+    stack.push_back(order[1]);
+    for (k = 2; k < n - 1; k++) {
+        size_t v = order[k];
+        if (side[v] != side[stack.back()]) {
+            for (size_t j = 0; j + 1 < stack.size(); j++) {
+                if (side[v] == 1) emit(stack[j + 1], stack[j], v);
+                else emit(stack[j], stack[j + 1], v);
+            }
+            stack.clear();
+            stack.push_back(order[k - 1]);
+            stack.push_back(v);
+        }
+        else {
+            size_t last = stack.back();
+            stack.pop_back();
+            while (!stack.empty()) {
+                size_t s = stack.back();
+                if (side[v] == 1) {
+                    if (!leftTurn(points[v], points[s], points[last])) break;
+                    emit(v, s, last);
+                }
+                else {
+                    if (!leftTurn(points[v], points[last], points[s])) break;
+                    emit(v, last, s);
+                }
+                last = s;
+                stack.pop_back();
+            }
+            stack.push_back(last);
+            stack.push_back(v);
+        }
+    }
+    size_t v = order[k];
+    for (size_t j = 0; j + 1 < stack.size(); j++) {
+        if (side[stack[j + 1]] == 1) emit(stack[j], stack[j + 1], v);
+        else emit(stack[j + 1], stack[j], v);
+    }
+    return true;
+}
+
+inline double signedArea(const float* xy, size_t count) {
+    double area = 0.0;
+    for (size_t i = 0, j = count - 1; i < count; j = i++) {
+        area += (double)xy[j * 2] * xy[i * 2 + 1] - (double)xy[i * 2] * xy[j * 2 + 1];
+    }
+    return area * 0.5;
+}
+
+}  // namespace Detail
+
+/*
+Триангуляция:
+1. Контуры копируются в общий список вершин со связями previous/next; внешний
+   обходится против часовой стрелки, дыры - по часовой (внутренность всегда слева)
+2. Разбиение диагоналями на монотонные части
+3. Обход получившихся циклов и триангуляция каждого за линейное время
+*/
+inline void triangulate(const Rings& rings, Mesh& mesh) {
+    mesh.points.clear();
+    mesh.ringSizes.clear();
+    mesh.indices.clear();
+    mesh.complete = false;
+
+    Detail::Partition part;
+    uint32_t pointBase = 0;
+    for (size_t r = 0; r < rings.size(); r++) {
+        const std::vector<float>& ring = rings[r];
+        size_t count = ring.size() / 2;
+        mesh.ringSizes.push_back(count);
+        mesh.points.insert(mesh.points.end(), ring.begin(), ring.begin() + count * 2);
+
+        // Вырожденный контур (< 3 точек) хранится, но в разбиении не участвует
+        if (count >= 3) {
+            bool counterClockwise = Detail::signedArea(ring.data(), count) > 0.0;
+            bool reverse = (r == 0) != counterClockwise;
+            uint32_t first = (uint32_t)part.vertices.size();
+            for (size_t i = 0; i < count; i++) {
+                uint32_t previous = first + (uint32_t)((i + count - 1) % count);
+                uint32_t next = first + (uint32_t)((i + 1) % count);
+                if (reverse) std::swap(previous, next);
+                part.vertices.push_back({ { ring[i * 2], ring[i * 2 + 1] }, pointBase + (uint32_t)i, previous, next });
+            }
+        }
+        pointBase += (uint32_t)count;
+    }
+    if (part.vertices.size() < 3 || !Detail::partition(part)) return;
+
+    std::vector<bool> visited(part.vertices.size(), false);
+    std::vector<Detail::Point> points;
+    std::vector<uint32_t> sources;
+    mesh.indices.reserve((part.vertices.size() - 2) * 3);
+    for (size_t start = 0; start < part.vertices.size(); start++) {
+        if (visited[start]) continue;
+        points.clear();
+        sources.clear();
+        size_t v = start;
+        do {
+            visited[v] = true;
+            points.push_back(part.vertices[v].p);
+            sources.push_back(part.vertices[v].source);
+            v = part.vertices[v].next;
+        } while (v != start && !visited[v]);
+        if (!Detail::triangulateMonotone(points, sources, mesh.indices)) {
+            mesh.indices.clear();
+            return;
+        }
+    }
+    mesh.complete = true;
+}
+
+/*
+Кэш триангуляций по хэшу контуров:
+1. Хэш FNV-1a по числу точек каждого контура и битам координат - O(n),
+   несравнимо дешевле самой триангуляции
+2. При совпадении хэша контуры сравниваются целиком - коллизия не подменит фигуру
+3. Результат общий (shared_ptr на неизменяемую сетку): одинаковые фигуры
+   делят одну триангуляцию
+*/
+class Cache {
+private:
+    std::unordered_map<uint64_t, std::shared_ptr<const Mesh>> meshes;
+    size_t hits, misses;
+
+    static uint64_t hashRings(const Rings& rings) {
+        uint64_t hash = 14695981039346656037ull;
+        auto mix = [&hash](const void* data, size_t size) {
+            const unsigned char* bytes = (const unsigned char*)data;
+            for (size_t i = 0; i < size; i++) {
+                hash ^= bytes[i];
+                hash *= 1099511628211ull;
+            }
+        };
+        for (const std::vector<float>& ring : rings) {
+            uint64_t count = ring.size() / 2;
+            mix(&count, sizeof(count));
+            mix(ring.data(), count * 2 * sizeof(float));
+        }
+        return hash;
+    }
+
+    static bool sameRings(const Mesh& mesh, const Rings& rings) {
+        if (mesh.ringSizes.size() != rings.size()) return false;
+        size_t offset = 0;
+        for (size_t r = 0; r < rings.size(); r++) {
+            size_t count = rings[r].size() / 2;
+            if (mesh.ringSizes[r] != count) return false;
+            if (std::memcmp(mesh.points.data() + offset, rings[r].data(), count * 2 * sizeof(float)) != 0) return false;
+            offset += count * 2;
+        }
+        return true;
+    }
+
+public:
+    Cache() : hits(0), misses(0) {}
+
+    std::shared_ptr<const Mesh> get(const Rings& rings) {
+        uint64_t hash = hashRings(rings);
+        auto it = meshes.find(hash);
+        if (it != meshes.end() && sameRings(*it->second, rings)) {
+            hits++;
+            return it->second;
+        }
+
+        misses++;
+        std::shared_ptr<Mesh> mesh = std::make_shared<Mesh>();
+        triangulate(rings, *mesh);
+        if (it == meshes.end()) meshes.emplace(hash, mesh);
+        return mesh;
+    }
+
+    void clear() { meshes.clear(); }
+    size_t size() const { return meshes.size(); }
+    size_t getHits() const { return hits; }
+    size_t getMisses() const { return misses; }
+};
+
+}  // namespace Triangulation
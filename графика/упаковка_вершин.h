@@ -0,0 +1,84 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+// ============================================
+// Квантование атрибутов вершин
+// ============================================
+
+// Упакованные атрибуты читаются через glVertexAttribPointer с normalized = GL_TRUE
+// (или GL_HALF_FLOAT) - в шейдере они снова становятся float.
+
+namespace VertexPacking {
+
+// float -> half (IEEE 754 binary16) с округлением к ближайшему
+inline uint16_t floatToHalf(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    uint32_t sign = (bits >> 16) & 0x8000u;
+    int32_t exponent = (int32_t)((bits >> 23) & 0xFFu) - 127 + 15;
+    uint32_t mantissa = bits & 0x7FFFFFu;
+
+    if (((bits >> 23) & 0xFFu) == 0xFFu) {
+        // Inf / NaN
+        return (uint16_t)(sign | 0x7C00u | (mantissa ? 0x200u : 0u));
+    }
+    if (exponent >= 31) {
+        // Переполнение -> бесконечность
+        return (uint16_t)(sign | 0x7C00u);
+    }
+    if (exponent <= 0) {
+        // Денормализованные числа (или ноль)
+        if (exponent < -10) return (uint16_t)sign;
+        mantissa |= 0x800000u;
+        uint32_t shift = (uint32_t)(14 - exponent);
+        uint32_t half = mantissa >> shift;
+        uint32_t rest = mantissa & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if (rest > halfway || (rest == halfway && (half & 1u))) half++;
+        return (uint16_t)(sign | half);
+    }
+
+    uint32_t half = sign | ((uint32_t)exponent << 10) | (mantissa >> 13);
+    uint32_t rest = mantissa & 0x1FFFu;
+    if (rest > 0x1000u || (rest == 0x1000u && (half & 1u))) half++;  // перенос в порядок допустим
+    return (uint16_t)half;
+}
+
+// [-1, 1] -> snorm16
+inline int16_t toSnorm16(float value) {
+    value = std::min(std::max(value, -1.0f), 1.0f);
+    return (int16_t)std::lround(value * 32767.0f);
+}
+
+// [0, 1] -> unorm8
+inline uint8_t toUnorm8(float value) {
+    value = std::min(std::max(value, 0.0f), 1.0f);
+    return (uint8_t)std::lround(value * 255.0f);
+}
+
+/*
+Октаэдрическое кодирование нормали:
+1. Проецируем единичный вектор на октаэдр |x| + |y| + |z| = 1
+2. Нижнюю половину (z < 0) "отворачиваем" в углы квадрата
+3. Получаем две координаты в [-1, 1] -> 2 x snorm16 (4 байта вместо 12)
+Декодирование - функция octDecode в вершинном шейдере.
+*/
+inline void octEncode(float x, float y, float z, int16_t& outX, int16_t& outY) {
+    float invL1 = 1.0f / (std::fabs(x) + std::fabs(y) + std::fabs(z));
+    float u = x * invL1;
+    float v = y * invL1;
+    if (z < 0.0f) {
+        float fu = (1.0f - std::fabs(v)) * (u >= 0.0f ? 1.0f : -1.0f);
+        float fv = (1.0f - std::fabs(u)) * (v >= 0.0f ? 1.0f : -1.0f);
+        u = fu;
+        v = fv;
+    }
+    outX = toSnorm16(u);
+    outY = toSnorm16(v);
+}
+
+}  // namespace VertexPacking
@@ -3,6 +3,19 @@
 #include <iostream>
 #include <vector>
 #include <cmath>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <memory>
+#include <chrono>
+#include "графика/статичные_меши.h"
+#include "графика/пул_вершин.h"
+#include "графика/объекты_gl.h"
+#include "графика/пространственный_индекс.h"
+#include "графика/очередь_отрисовки.h"
+#include "графика/триангуляция.h"
+#include "графика/безоконный_режим.h"
+#include "графика/профилировщик.h"
 
 // Шейдерные программы
 const char* vertexShaderSource = R"(
@@ -30,26 +43,506 @@ const char* fragmentShaderSource = R"(
     }
 )";
 
+// Вершинный шейдер для экземпляров: общая единичная геометрия + преобразование и цвет экземпляра
+const char* instancedVertexShaderSource = R"(
+    #version 330 core
+    layout (location = 0) in vec2 aPos;
+    layout (location = 2) in vec4 iTransform;  // x, y, масштаб, поворот
+    layout (location = 3) in vec4 iColor;
+
+    out vec3 fragColor;
+
+    void main()
+    {
+        float c = cos(iTransform.w);
+        float s = sin(iTransform.w);
+        vec2 p = mat2(c, s, -s, c) * aPos * iTransform.z + iTransform.xy;
+        gl_Position = vec4(p, 0.0, 1.0);
+        fragColor = iColor.rgb;
+    }
+)";
+
+// Фигуры по функции расстояния (SDF): один квадрат на фигуру, край - во фрагментном шейдере.
+// Все размеры в пикселях, начало координат - левый нижний угол окна
+const char* sdfVertexShaderSource = R"(
+    #version 330 core
+    layout (location = 0) in vec2 aCorner;   // (+-1, +-1)
+    layout (location = 2) in vec4 iRect;     // центр и полуразмеры
+    layout (location = 3) in vec2 iShape;    // радиус скругления, толщина контура (0 - заливка)
+    layout (location = 4) in vec4 iColor;
+
+    uniform vec2 viewportSize;
+
+    out vec2 localPos;
+    flat out vec2 halfSize;
+    flat out vec2 shape;
+    flat out vec4 color;
+
+    void main()
+    {
+        // Квадрат шире фигуры на пиксель - место под сглаживание
+        localPos = aCorner * (iRect.zw + 1.0);
+        vec2 pixel = iRect.xy + localPos;
+        gl_Position = vec4(pixel / viewportSize * 2.0 - 1.0, 0.0, 1.0);
+        halfSize = iRect.zw;
+        shape = iShape;
+        color = iColor;
+    }
+)";
+
+const char* sdfFragmentShaderSource = R"(
+    #version 330 core
+    in vec2 localPos;
+    flat in vec2 halfSize;
+    flat in vec2 shape;
+    flat in vec4 color;
+    out vec4 FragColor;
+
+    // Расстояние до прямоугольника со скруглёнными углами (< 0 внутри)
+    float roundedBox(vec2 p, vec2 b, float r)
+    {
+        vec2 q = abs(p) - b + r;
+        return length(max(q, 0.0)) + min(max(q.x, q.y), 0.0) - r;
+    }
+
+    void main()
+    {
+        float d = roundedBox(localPos, halfSize, shape.x);
+        if (shape.y > 0.0) {
+            // Контур: полоса толщиной shape.y внутрь от края
+            d = abs(d + shape.y * 0.5) - shape.y * 0.5;
+        }
+        // Аналитическое сглаживание: покрытие пикселя по расстоянию до края
+        float alpha = clamp(0.5 - d / fwidth(d), 0.0, 1.0);
+        if (alpha <= 0.0) discard;
+        FragColor = vec4(color.rgb, color.a * alpha);
+    }
+)";
+
+// ============================================
+// Пакетная отрисовка: все фигуры кадра - в одном буфере
+// ============================================
+
+// Аффинное преобразование 2D: x' = a*x + c*y + tx, y' = b*x + d*y + ty
+struct Transform2D {
+    float a, b, c, d, tx, ty;
+
+    static Transform2D identity() {
+        return { 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f };
+    }
+
+    // Масштаб, поворот (радианы) и перенос
+    static Transform2D make(float x, float y, float scale, float rotation = 0.0f) {
+        float cosA = cosf(rotation) * scale;
+        float sinA = sinf(rotation) * scale;
+        return { cosA, sinA, -sinA, cosA, x, y };
+    }
+
+    void apply(float x, float y, float& outX, float& outY) const {
+        outX = a * x + c * y + tx;
+        outY = b * x + d * y + ty;
+    }
+};
+
+// Вершина пакета: позиция + цвет RGBA8 (12 байт вместо 20)
+struct BatchVertex {
+    float x, y;
+    uint8_t r, g, b, a;
+};
+
+/*
+Пакетный рендерер:
+1. Фигуры не рисуются сами, а дописывают в общий массив уже преобразованные вершины
+2. Любой примитив приводится к индексированному списку треугольников:
+   GL_TRIANGLE_FAN -> (0, i, i+1), GL_TRIANGLE_STRIP -> (i, i+1, i+2) с чередованием обхода,
+   GL_LINES / GL_LINE_STRIP -> по прямоугольнику заданной толщины (в пикселях) на отрезок
+3. Накопленное загружается в страницу - свои VAO/VBO/EBO - одним glBufferSubData
+   (буфер перед этим "осиротевает", чтобы не ждать GPU)
+4. Переполненный пакет закрывается в свою страницу, накопление продолжается со следующей;
+   submit() отдаёт в очередь по команде glDrawElements на страницу. Страницы создаются
+   по мере надобности и переиспользуются в следующем кадре, память каждой ограничена
+   MAX_VERTICES
+*/
+class ShapeBatch {
+public:
+    static const int MAX_VERTICES = 1 << 18;
+    static const int MAX_INDICES = MAX_VERTICES * 3 / 2;
+
+private:
+    struct Page {
+        unsigned int VAO, VBO, EBO;
+        GLsizei indexCount;
+    };
+
+    std::vector<Page> pages;
+    size_t usedPages;               // закрыто страниц с прошлого submit()
+    std::vector<BatchVertex> vertices;
+    std::vector<uint32_t> indices;
+    float pixelWidth, pixelHeight;  // размер пикселя в координатах NDC
+
+    static uint8_t toByte(float value) {
+        return (uint8_t)(std::min(std::max(value, 0.0f), 1.0f) * 255.0f + 0.5f);
+    }
+
+    // Вершины треугольника t веера, ленты или списка треугольников
+    static void triangleCorners(int mode, int t, uint32_t corners[3]) {
+        if (mode == GL_TRIANGLE_FAN) {
+            corners[0] = 0; corners[1] = t + 1; corners[2] = t + 2;
+        }
+        else if (mode == GL_TRIANGLE_STRIP) {
+            // Каждый второй треугольник ленты - с обратным обходом
+            corners[0] = t;
+            corners[1] = (t & 1) ? t + 2 : t + 1;
+            corners[2] = (t & 1) ? t + 1 : t + 2;
+        }
+        else {
+            corners[0] = t * 3; corners[1] = t * 3 + 1; corners[2] = t * 3 + 2;
+        }
+    }
+
+    void appendVertex(const float* positions, int positionStride, const float* colors, int colorStride,
+        uint32_t i, const Transform2D& transform) {
+        BatchVertex v;
+        transform.apply(positions[i * positionStride], positions[i * positionStride + 1], v.x, v.y);
+        const float* color = colors + i * colorStride;
+        v.r = toByte(color[0]);
+        v.g = toByte(color[1]);
+        v.b = toByte(color[2]);
+        v.a = 255;
+        vertices.push_back(v);
+    }
+
+    // Место под count вершин и indexCount индексов (при нехватке - новая страница)
+    uint32_t reserve(int count, int indexCount) {
+        if (vertices.size() + count > (size_t)MAX_VERTICES ||
+            indices.size() + indexCount > (size_t)MAX_INDICES) {
+            closePage();
+        }
+        return (uint32_t)vertices.size();
+    }
+
+    Page createPage() {
+        Page page = { 0, 0, 0, 0 };
+        glGenVertexArrays(1, &page.VAO);
+        glGenBuffers(1, &page.VBO);
+        glGenBuffers(1, &page.EBO);
+
+        glBindVertexArray(page.VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, page.VBO);
+        glBufferData(GL_ARRAY_BUFFER, MAX_VERTICES * sizeof(BatchVertex), NULL, GL_STREAM_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, page.EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, MAX_INDICES * sizeof(uint32_t), NULL, GL_STREAM_DRAW);
+
+        // Позиции
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(BatchVertex), (void*)0);
+        glEnableVertexAttribArray(0);
+
+        // Цвета: байты нормализуются в [0, 1], шейдер тот же
+        glVertexAttribPointer(1, 3, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(BatchVertex),
+            (void*)offsetof(BatchVertex, r));
+        glEnableVertexAttribArray(1);
+
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        return page;
+    }
+
+    // Загрузить накопленное в "осиротевшие" буферы следующей страницы
+    void closePage() {
+        if (indices.empty()) {
+            vertices.clear();
+            return;
+        }
+        if (usedPages == pages.size()) pages.push_back(createPage());
+        Page& page = pages[usedPages++];
+        page.indexCount = (GLsizei)indices.size();
+
+        glBindVertexArray(page.VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, page.VBO);
+        glBufferData(GL_ARRAY_BUFFER, MAX_VERTICES * sizeof(BatchVertex), NULL, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, vertices.size() * sizeof(BatchVertex), vertices.data());
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, MAX_INDICES * sizeof(uint32_t), NULL, GL_STREAM_DRAW);
+        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, indices.size() * sizeof(uint32_t), indices.data());
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        vertices.clear();
+        indices.clear();
+    }
+
+    void addLineSegment(float x0, float y0, float x1, float y1, uint8_t r, uint8_t g, uint8_t b,
+        float halfWidth) {
+        float dx = (x1 - x0) / pixelWidth;
+        float dy = (y1 - y0) / pixelHeight;
+        float length = sqrtf(dx * dx + dy * dy);
+        if (length == 0.0f) return;
+
+        // Нормаль к отрезку в пикселях -> обратно в NDC
+        float nx = -dy / length * halfWidth * pixelWidth;
+        float ny = dx / length * halfWidth * pixelHeight;
+
+        uint32_t base = reserve(4, 6);
+        vertices.push_back({ x0 + nx, y0 + ny, r, g, b, 255 });
+        vertices.push_back({ x0 - nx, y0 - ny, r, g, b, 255 });
+        vertices.push_back({ x1 - nx, y1 - ny, r, g, b, 255 });
+        vertices.push_back({ x1 + nx, y1 + ny, r, g, b, 255 });
+        uint32_t quad[6] = { base, base + 1, base + 2, base + 2, base + 3, base };
+        indices.insert(indices.end(), quad, quad + 6);
+    }
+
+public:
+    ShapeBatch() : usedPages(0), pixelWidth(2.0f / 800.0f), pixelHeight(2.0f / 600.0f) {
+        vertices.reserve(MAX_VERTICES);
+        indices.reserve(MAX_INDICES);
+    }
+
+    ~ShapeBatch() {
+        for (Page& page : pages) {
+            glDeleteBuffers(1, &page.EBO);
+            glDeleteBuffers(1, &page.VBO);
+            glDeleteVertexArrays(1, &page.VAO);
+        }
+    }
+
+    ShapeBatch(const ShapeBatch&) = delete;
+    ShapeBatch& operator=(const ShapeBatch&) = delete;
+
+    // Первая страница - заранее, остальные появятся при переполнении
+    void create() {
+        if (pages.empty()) pages.push_back(createPage());
+    }
+
+    // Размер окна нужен для толщины линий в пикселях
+    void setViewport(int width, int height) {
+        pixelWidth = 2.0f / width;
+        pixelHeight = 2.0f / height;
+    }
+
+    // Добавить примитив: positions - (x, y) с шагом positionStride float,
+    // colors - (r, g, b) с шагом colorStride (0 - один цвет на все вершины)
+    void addPrimitive(int mode, const float* positions, int positionStride,
+        const float* colors, int colorStride, int count, const Transform2D& transform,
+        float lineWidth = 1.0f) {
+        if (mode == GL_LINES || mode == GL_LINE_STRIP) {
+            int step = mode == GL_LINES ? 2 : 1;
+            for (int i = 0; i + 1 < count; i += step) {
+                float x0, y0, x1, y1;
+                transform.apply(positions[i * positionStride], positions[i * positionStride + 1], x0, y0);
+                transform.apply(positions[(i + 1) * positionStride], positions[(i + 1) * positionStride + 1], x1, y1);
+                const float* color = colors + i * colorStride;
+                addLineSegment(x0, y0, x1, y1, toByte(color[0]), toByte(color[1]), toByte(color[2]),
+                    lineWidth * 0.5f);
+            }
+            return;
+        }
+
+        if (count < 3) return;
+        int triangleCount = mode == GL_TRIANGLES ? count / 3 : count - 2;
+        uint32_t corners[3];
+
+        // Примитив больше страницы: треугольники по одному, каждый со своими вершинами -
+        // так он делится между страницами
+        if (count > MAX_VERTICES || (size_t)triangleCount * 3 > (size_t)MAX_INDICES) {
+            for (int t = 0; t < triangleCount; t++) {
+                triangleCorners(mode, t, corners);
+                uint32_t base = reserve(3, 3);
+                for (int k = 0; k < 3; k++) {
+                    appendVertex(positions, positionStride, colors, colorStride, corners[k], transform);
+                    indices.push_back(base + k);
+                }
+            }
+            return;
+        }
+
+        uint32_t base = reserve(count, triangleCount * 3);
+        for (int i = 0; i < count; i++) {
+            appendVertex(positions, positionStride, colors, colorStride, i, transform);
+        }
+        for (int t = 0; t < triangleCount; t++) {
+            triangleCorners(mode, t, corners);
+            indices.push_back(base + corners[0]);
+            indices.push_back(base + corners[1]);
+            indices.push_back(base + corners[2]);
+        }
+    }
+
+    // Загрузить накопленное сейчас, а нарисовать командами очереди - по одной на
+    // страницу, в порядке заполнения. Не чаще раза на queue.flush(): страницы
+    // переиспользуются, следующая загрузка заменит буферы, которые читают команды
+    void submit(RenderQueue::Queue& queue, unsigned int program, uint8_t layer) {
+        closePage();
+        for (size_t i = 0; i < usedPages; i++) {
+            RenderQueue::DrawCommand command;
+            command.program = program;
+            command.vertexArray = pages[i].VAO;
+            command.count = pages[i].indexCount;
+            command.indexed = true;
+            queue.submit(command, layer);
+        }
+        usedPages = 0;
+    }
+};
+
+// ============================================
+// Общий буфер вершин фигур
+// ============================================
+
+/*
+Геометрия всех Shape2D в одном VBO:
+1. create() фигуры берёт диапазон у GeometryPool::VertexMegabuffer - без glGenBuffers
+2. Один VAO, смотрящий в общий буфер; фигуре свой VAO не нужен
+3. Удаление фигуры только возвращает диапазон в список свободных
+4. defragment() раз в кадр сдвигает часть данных к началу буфера
+Фигура рисуется glDrawArrays(first = смещение / размер вершины), поэтому диапазоны
+в буфере выравниваются на размер вершины (позиция и цвет - 5 float).
+Если буфер вырос (сменился объект), VAO перепривязывается при следующей отрисовке.
+*/
+class ShapeGeometryPool {
+private:
+    static const size_t VERTEX_SIZE = 5 * sizeof(float);
+
+    GeometryPool::VertexMegabuffer buffer;
+    GLHandle::VertexArray VAO;
+    unsigned int boundGeneration;
+
+    void bind() {
+        glBindVertexArray(VAO.get());
+        if (boundGeneration == buffer.getGeneration()) return;
+
+        glBindBuffer(GL_ARRAY_BUFFER, buffer.getBuffer());
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, VERTEX_SIZE, (void*)0);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, VERTEX_SIZE, (void*)(2 * sizeof(float)));
+        glEnableVertexAttribArray(1);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        boundGeneration = buffer.getGeneration();
+    }
+
+public:
+    ShapeGeometryPool() : boundGeneration(0) {
+    }
+
+    void create(size_t initialBytes = 1 << 20) {
+        buffer.create(initialBytes);
+        VAO = GLHandle::VertexArray::generate();
+    }
+
+    GeometryPool::Handle upload(const float* data, size_t floatCount) {
+        size_t bytes = floatCount * sizeof(float);
+        GeometryPool::Handle handle = buffer.allocate(bytes, VERTEX_SIZE);
+        buffer.upload(handle, data, bytes);
+        return handle;
+    }
+
+    void release(GeometryPool::Handle handle) {
+        buffer.free(handle);
+    }
+
+    void draw(GeometryPool::Handle handle, int mode, int vertexCount) {
+        if (handle == GeometryPool::INVALID_HANDLE) return;
+        bind();
+        glDrawArrays(mode, (GLint)(buffer.getOffset(handle) / VERTEX_SIZE), vertexCount);
+        glBindVertexArray(0);
+    }
+
+    // Команда очереди для диапазона: смещение берётся сейчас, поэтому defragment()
+    // нужно звать до submit, а не между submit и queue.flush()
+    RenderQueue::DrawCommand command(GeometryPool::Handle handle, int mode, int vertexCount) {
+        bind();
+        glBindVertexArray(0);
+        RenderQueue::DrawCommand result;
+        result.vertexArray = VAO.get();
+        result.mode = mode;
+        result.first = (int)(buffer.getOffset(handle) / VERTEX_SIZE);
+        result.count = handle == GeometryPool::INVALID_HANDLE ? 0 : vertexCount;
+        return result;
+    }
+
+    size_t defragment(size_t budgetBytes) {
+        return buffer.defragment(budgetBytes);
+    }
+
+    const GeometryPool::VertexMegabuffer& getBuffer() const { return buffer; }
+};
+
+/*
+Владение геометрией Shape2D:
+1. Фигура владеет диапазоном общего буфера (pool + geometry) - копировать её нельзя,
+   иначе диапазон освободят дважды; перемещение передаёт диапазон и обнуляет источник
+2. vertices - только промежуточная копия для загрузки: после create() она освобождается,
+   на GPU уже всё есть. Поэтому appendTo() (пакет собирается из CPU-данных)
+   работает лишь с фигурами, для которых create() не вызывали
+*/
 class Shape2D {
 protected:
-    unsigned int VAO, VBO;
+    ShapeGeometryPool* pool;
+    GeometryPool::Handle geometry;
     std::vector<float> vertices;
+    int vertexCount;
     int drawMode;
 
+    void releaseGeometry() {
+        if (pool) pool->release(geometry);
+        pool = nullptr;
+        geometry = GeometryPool::INVALID_HANDLE;
+    }
+
 public:
-    Shape2D() : VAO(0), VBO(0), drawMode(GL_TRIANGLES) {}
+    Shape2D() : pool(nullptr), geometry(GeometryPool::INVALID_HANDLE), vertexCount(0), drawMode(GL_TRIANGLES) {}
 
-    virtual void create() = 0;
+    Shape2D(const Shape2D&) = delete;
+    Shape2D& operator=(const Shape2D&) = delete;
 
-    void render() {
-        glBindVertexArray(VAO);
-        glDrawArrays(drawMode, 0, vertices.size() / 5);
-        glBindVertexArray(0);
+    Shape2D(Shape2D&& other) noexcept
+        : pool(other.pool), geometry(other.geometry), vertices(std::move(other.vertices)),
+        vertexCount(other.vertexCount), drawMode(other.drawMode) {
+        other.pool = nullptr;
+        other.geometry = GeometryPool::INVALID_HANDLE;
+    }
+
+    Shape2D& operator=(Shape2D&& other) noexcept {
+        if (this != &other) {
+            releaseGeometry();
+            pool = other.pool;
+            geometry = other.geometry;
+            vertices = std::move(other.vertices);
+            vertexCount = other.vertexCount;
+            drawMode = other.drawMode;
+            other.pool = nullptr;
+            other.geometry = GeometryPool::INVALID_HANDLE;
+        }
+        return *this;
+    }
+
+    // Загрузка vertices (позиция + цвет, 5 float на вершину) в общий буфер вершин
+    virtual void create(ShapeGeometryPool& geometryPool) {
+        releaseGeometry();
+        pool = &geometryPool;
+        vertexCount = (int)vertices.size() / 5;
+        geometry = pool->upload(vertices.data(), vertices.size());
+        std::vector<float>().swap(vertices);
+    }
+
+    virtual void render() {
+        if (pool) pool->draw(geometry, drawMode, vertexCount);
+    }
+
+    // Вместо render(): отрисовка командой очереди (после create())
+    virtual void submit(RenderQueue::Queue& queue, unsigned int program, uint8_t layer) {
+        if (!pool || geometry == GeometryPool::INVALID_HANDLE) return;
+        RenderQueue::DrawCommand command = pool->command(geometry, drawMode, vertexCount);
+        command.program = program;
+        queue.submit(command, layer);
+    }
+
+    // Вместо render(): дописать фигуру в пакет (create() для этого не нужен)
+    virtual void appendTo(ShapeBatch& batch, const Transform2D& transform) const {
+        batch.addPrimitive(drawMode, vertices.data(), 5, vertices.data() + 2, 5,
+            (int)vertices.size() / 5, transform);
     }
 
     virtual ~Shape2D() {
-        if (VBO) glDeleteBuffers(1, &VBO);
-        if (VAO) glDeleteVertexArrays(1, &VAO);
+        releaseGeometry();
     }
 };
 
@@ -64,28 +557,6 @@ public:
         };
         drawMode = GL_TRIANGLES;
     }
-
-    void create() override {
-        glGenVertexArrays(1, &VAO);
-        glGenBuffers(1, &VBO);
-
-        glBindVertexArray(VAO);
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float),
-            vertices.data(), GL_STATIC_DRAW);
-
-        // Позиции
-        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
-        glEnableVertexAttribArray(0);
-
-        // Цвета
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float),
-            (void*)(2 * sizeof(float)));
-        glEnableVertexAttribArray(1);
-
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glBindVertexArray(0);
-    }
 };
 
 class Rectangle : public Shape2D {
@@ -102,97 +573,376 @@ public:
         };
         drawMode = GL_TRIANGLES;
     }
+};
 
-    void create() override {
-        glGenVertexArrays(1, &VAO);
-        glGenBuffers(1, &VBO);
-
-        glBindVertexArray(VAO);
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float),
-            vertices.data(), GL_STATIC_DRAW);
+class Line : public Shape2D {
+private:
+    float thickness;
 
-        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
-        glEnableVertexAttribArray(0);
+public:
+    Line(float r = 1.0f, float g = 1.0f, float b = 0.0f, float thickness = 2.0f) : thickness(thickness) {
+        vertices = {
+            // Позиции      // Цвета
+           -0.5f,  0.0f,    r, g, b,
+            0.5f,  0.0f,    r, g, b
+        };
+        drawMode = GL_LINES;
+    }
 
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float),
-            (void*)(2 * sizeof(float)));
-        glEnableVertexAttribArray(1);
+    // В пакете линия - прямоугольник толщиной thickness пикселей
+    void appendTo(ShapeBatch& batch, const Transform2D& transform) const override {
+        batch.addPrimitive(drawMode, vertices.data(), 5, vertices.data() + 2, 5,
+            (int)vertices.size() / 5, transform, thickness);
+    }
+};
 
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glBindVertexArray(0);
+// Произвольный многоугольник, в том числе с дырами (контуры - в координатах экрана).
+// Треугольники берутся из кэша: одинаковые контуры триангулируются один раз
+class Polygon : public Shape2D {
+public:
+    Polygon(Triangulation::Cache& cache, const Triangulation::Rings& rings,
+        float r = 0.8f, float g = 0.6f, float b = 0.2f) {
+        std::shared_ptr<const Triangulation::Mesh> mesh = cache.get(rings);
+        vertices.reserve(mesh->indices.size() * 5);
+        for (uint32_t index : mesh->indices) {
+            vertices.insert(vertices.end(), { mesh->points[index * 2], mesh->points[index * 2 + 1], r, g, b });
+        }
+        drawMode = GL_TRIANGLES;
     }
 };
 
-class Circle : public Shape2D {
+// Короткоживущая искра: правильный многоугольник, вершины сразу в координатах экрана
+class Spark : public Shape2D {
+private:
+    int expiresAt;
+
 public:
-    Circle(int segments = 50, float r = 0.0f, float g = 0.0f, float b = 1.0f) {
-        float radius = 0.5f;
-        float M_PI = 3.14f;
-        for (int i = 0; i <= segments; i++) {
-            float theta = 2.0f * M_PI * float(i) / float(segments);
-            float x = radius * cosf(theta);
-            float y = radius * sinf(theta);
-
-            vertices.push_back(x);
-            vertices.push_back(y);
-            vertices.push_back(r);
-            vertices.push_back(g);
-            vertices.push_back(b);
+    Spark(float x, float y, float radius, int sides, float r, float g, float b, int expiresAt)
+        : expiresAt(expiresAt) {
+        vertices = { x, y, r, g, b };
+        for (int i = 0; i <= sides; i++) {
+            float theta = 2.0f * 3.14159265f * float(i) / float(sides);
+            vertices.insert(vertices.end(), { x + radius * cosf(theta), y + radius * sinf(theta),
+                r * 0.6f, g * 0.6f, b * 0.6f });
         }
         drawMode = GL_TRIANGLE_FAN;
     }
 
-    void create() override {
-        glGenVertexArrays(1, &VAO);
-        glGenBuffers(1, &VBO);
+    int getExpiry() const { return expiresAt; }
+};
 
-        glBindVertexArray(VAO);
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float),
-            vertices.data(), GL_STATIC_DRAW);
+// ============================================
+// Общая геометрия фигур + поток экземпляров
+// ============================================
+
+enum class ShapeKind { Triangle, Rectangle, Circle, Line, Count };
+
+// Данные одного экземпляра: 20 байт вместо копии всей геометрии
+struct ShapeInstance {
+    float x, y, scale, rotation;
+    uint8_t r, g, b, a;
+};
+
+/*
+Реестр фигур (flyweight):
+1. Для каждого типа фигуры один VBO с единичной геометрией без цвета - загружается один раз
+2. Экземпляры типа лежат в отдельном массиве и своём VBO (атрибуты 2, 3 с divisor = 1)
+3. Изменение экземпляра (цвет, позиция) помечает диапазон изменённых индексов -
+   при отрисовке перезагружается только он, геометрия не трогается
+4. Каждый тип рисуется одним glDrawArraysInstanced
+Память: геометрия - константа на тип, дальше 20 байт на экземпляр.
+*/
+class ShapeRegistry {
+private:
+    static const int KIND_COUNT = (int)ShapeKind::Count;
+    static const int CIRCLE_SEGMENTS = 32;
+
+    struct Kind {
+        unsigned int VAO, meshVBO, instanceVBO;
+        int vertexCount;
+        int drawMode;
+        size_t capacity;                    // сколько экземпляров вмещает instanceVBO
+        std::vector<ShapeInstance> instances;
+        size_t dirtyBegin, dirtyEnd;        // изменённый диапазон [begin, end)
+    };
+
+    Kind kinds[KIND_COUNT];
+
+    // Расширить изменённый диапазон до index (пустой диапазон начинается с него)
+    static void markDirty(Kind& k, size_t index) {
+        if (k.dirtyBegin >= k.dirtyEnd) {
+            k.dirtyBegin = index;
+            k.dirtyEnd = index + 1;
+        }
+        else {
+            k.dirtyBegin = std::min(k.dirtyBegin, index);
+            k.dirtyEnd = std::max(k.dirtyEnd, index + 1);
+        }
+    }
+
+    void createKind(ShapeKind kind, const float* positions, int vertexCount, int drawMode) {
+        Kind& k = kinds[(int)kind];
+        k.vertexCount = vertexCount;
+        k.drawMode = drawMode;
 
-        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
+        glGenVertexArrays(1, &k.VAO);
+        glGenBuffers(1, &k.meshVBO);
+        glGenBuffers(1, &k.instanceVBO);
+
+        glBindVertexArray(k.VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, k.meshVBO);
+        glBufferData(GL_ARRAY_BUFFER, vertexCount * 2 * sizeof(float), positions, GL_STATIC_DRAW);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
         glEnableVertexAttribArray(0);
 
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float),
-            (void*)(2 * sizeof(float)));
-        glEnableVertexAttribArray(1);
+        glBindBuffer(GL_ARRAY_BUFFER, k.instanceVBO);
+        glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(ShapeInstance), (void*)0);
+        glEnableVertexAttribArray(2);
+        glVertexAttribDivisor(2, 1);
+        glVertexAttribPointer(3, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(ShapeInstance),
+            (void*)offsetof(ShapeInstance, r));
+        glEnableVertexAttribArray(3);
+        glVertexAttribDivisor(3, 1);
 
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
         glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    static uint8_t toByte(float value) {
+        return (uint8_t)(std::min(std::max(value, 0.0f), 1.0f) * 255.0f + 0.5f);
+    }
+
+public:
+    ShapeRegistry() {
+        for (Kind& k : kinds) {
+            k.VAO = k.meshVBO = k.instanceVBO = 0;
+            k.vertexCount = 0;
+            k.drawMode = GL_TRIANGLES;
+            k.capacity = 0;
+            k.dirtyBegin = k.dirtyEnd = 0;
+        }
+    }
+
+    ~ShapeRegistry() {
+        for (Kind& k : kinds) {
+            if (k.instanceVBO) glDeleteBuffers(1, &k.instanceVBO);
+            if (k.meshVBO) glDeleteBuffers(1, &k.meshVBO);
+            if (k.VAO) glDeleteVertexArrays(1, &k.VAO);
+        }
+    }
+
+    ShapeRegistry(const ShapeRegistry&) = delete;
+    ShapeRegistry& operator=(const ShapeRegistry&) = delete;
+
+    // Загрузить единичную геометрию всех типов (те же контуры, что у Triangle, Rectangle, ...)
+    void create() {
+        static const float triangle[] = { 0.0f, 0.5f, -0.5f, -0.5f, 0.5f, -0.5f };
+        static const float rectangle[] = { -0.5f, 0.5f, -0.5f, -0.5f, 0.5f, -0.5f, 0.5f, 0.5f };
+        static constexpr std::array<float, (CIRCLE_SEGMENTS + 2) * 2> circle =
+            StaticMesh::scaled(StaticMesh::circleFan<CIRCLE_SEGMENTS>(), 0.5f);
+        static const float line[] = { -0.5f, 0.0f, 0.5f, 0.0f };
+
+        createKind(ShapeKind::Triangle, triangle, 3, GL_TRIANGLES);
+        createKind(ShapeKind::Rectangle, rectangle, 4, GL_TRIANGLE_FAN);
+        createKind(ShapeKind::Circle, circle.data(), CIRCLE_SEGMENTS + 2, GL_TRIANGLE_FAN);
+        createKind(ShapeKind::Line, line, 2, GL_LINES);
+    }
+
+    // Добавить экземпляр; возвращает его индекс внутри типа
+    size_t add(ShapeKind kind, float x, float y, float scale, float rotation,
+        float r, float g, float b) {
+        Kind& k = kinds[(int)kind];
+        size_t index = k.instances.size();
+        k.instances.push_back({ x, y, scale, rotation, toByte(r), toByte(g), toByte(b), 255 });
+        markDirty(k, index);
+        return index;
+    }
+
+    // Доступ на изменение: экземпляр попадает в диапазон для перезагрузки
+    ShapeInstance& edit(ShapeKind kind, size_t index) {
+        Kind& k = kinds[(int)kind];
+        markDirty(k, index);
+        return k.instances[index];
+    }
+
+    void setColor(ShapeKind kind, size_t index, float r, float g, float b) {
+        ShapeInstance& instance = edit(kind, index);
+        instance.r = toByte(r);
+        instance.g = toByte(g);
+        instance.b = toByte(b);
+    }
+
+    // Загрузить изменённые экземпляры и поставить в очередь по команде на тип
+    void submit(RenderQueue::Queue& queue, unsigned int program, uint8_t layer) {
+        for (Kind& k : kinds) {
+            if (k.instances.empty()) continue;
+
+            if (k.dirtyBegin < k.dirtyEnd) {
+                glBindBuffer(GL_ARRAY_BUFFER, k.instanceVBO);
+                if (k.instances.size() > k.capacity) {
+                    // Буфер мал - пересоздаём с запасом и грузим всё
+                    k.capacity = std::max<size_t>(k.instances.size(), k.capacity * 2);
+                    glBufferData(GL_ARRAY_BUFFER, k.capacity * sizeof(ShapeInstance), NULL, GL_DYNAMIC_DRAW);
+                    k.dirtyBegin = 0;
+                    k.dirtyEnd = k.instances.size();
+                }
+                glBufferSubData(GL_ARRAY_BUFFER, k.dirtyBegin * sizeof(ShapeInstance),
+                    (k.dirtyEnd - k.dirtyBegin) * sizeof(ShapeInstance), &k.instances[k.dirtyBegin]);
+                glBindBuffer(GL_ARRAY_BUFFER, 0);
+                k.dirtyBegin = k.dirtyEnd = 0;
+            }
+
+            RenderQueue::DrawCommand command;
+            command.program = program;
+            command.vertexArray = k.VAO;
+            command.mode = k.drawMode;
+            command.count = k.vertexCount;
+            command.instanceCount = (GLsizei)k.instances.size();
+            queue.submit(command, layer);
+        }
     }
 };
 
-class Line : public Shape2D {
+// ============================================
+// Круги, кольца и скруглённые прямоугольники по SDF
+// ============================================
+
+// Экземпляр SDF-фигуры: круг - это прямоугольник с радиусом скругления = полуразмеру
+struct SDFShape {
+    float x, y, halfWidth, halfHeight;
+    float radius, thickness;
+    uint8_t r, g, b, a;
+};
+
+/*
+Отрисовка SDF-фигур:
+1. Геометрия общая - 4 угла квадрата (GL_TRIANGLE_STRIP), остальное из потока экземпляров
+2. Вершинный шейдер растягивает квадрат по размеру фигуры (+1 пиксель на сглаживание)
+3. Фрагментный шейдер считает расстояние до края и по нему - покрытие пикселя
+4. Края гладкие при любом размере, а вершин всегда 4 - и у точки, и у круга на весь экран
+Нужно смешивание: команда включает GL_BLEND, функция смешивания задаётся один раз при запуске.
+*/
+class SDFShapeRenderer {
+private:
+    unsigned int VAO, quadVBO, instanceVBO;
+    unsigned int program;
+    int viewportLoc;
+    std::vector<SDFShape> shapes;
+    size_t capacity;
+    bool dirty;
+    float viewportWidth, viewportHeight;
+
+    static uint8_t toByte(float value) {
+        return (uint8_t)(std::min(std::max(value, 0.0f), 1.0f) * 255.0f + 0.5f);
+    }
+
+    size_t add(float x, float y, float halfWidth, float halfHeight, float radius, float thickness,
+        float r, float g, float b) {
+        radius = std::min(radius, std::min(halfWidth, halfHeight));
+        shapes.push_back({ x, y, halfWidth, halfHeight, radius, thickness,
+            toByte(r), toByte(g), toByte(b), 255 });
+        dirty = true;
+        return shapes.size() - 1;
+    }
+
 public:
-    Line(float r = 1.0f, float g = 1.0f, float b = 0.0f, float thickness = 2.0f) {
-        vertices = {
-            // Позиции      // Цвета
-           -0.5f,  0.0f,    r, g, b,
-            0.5f,  0.0f,    r, g, b
-        };
-        drawMode = GL_LINES;
+    SDFShapeRenderer() : VAO(0), quadVBO(0), instanceVBO(0), program(0), viewportLoc(-1),
+        capacity(0), dirty(false), viewportWidth(800.0f), viewportHeight(600.0f) {}
+
+    ~SDFShapeRenderer() {
+        if (instanceVBO) glDeleteBuffers(1, &instanceVBO);
+        if (quadVBO) glDeleteBuffers(1, &quadVBO);
+        if (VAO) glDeleteVertexArrays(1, &VAO);
     }
 
-    void create() override {
+    SDFShapeRenderer(const SDFShapeRenderer&) = delete;
+    SDFShapeRenderer& operator=(const SDFShapeRenderer&) = delete;
+
+    // shaderProgram - из sdfVertexShaderSource и sdfFragmentShaderSource
+    void create(unsigned int shaderProgram) {
+        static const float corners[] = { -1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f };
+
+        program = shaderProgram;
+        viewportLoc = glGetUniformLocation(program, "viewportSize");
+
         glGenVertexArrays(1, &VAO);
-        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &quadVBO);
+        glGenBuffers(1, &instanceVBO);
 
         glBindVertexArray(VAO);
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float),
-            vertices.data(), GL_STATIC_DRAW);
-
-        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
+        glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
         glEnableVertexAttribArray(0);
 
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float),
-            (void*)(2 * sizeof(float)));
-        glEnableVertexAttribArray(1);
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(SDFShape), (void*)0);
+        glEnableVertexAttribArray(2);
+        glVertexAttribDivisor(2, 1);
+        glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(SDFShape),
+            (void*)offsetof(SDFShape, radius));
+        glEnableVertexAttribArray(3);
+        glVertexAttribDivisor(3, 1);
+        glVertexAttribPointer(4, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(SDFShape),
+            (void*)offsetof(SDFShape, r));
+        glEnableVertexAttribArray(4);
+        glVertexAttribDivisor(4, 1);
 
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
         glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    void setViewport(int width, int height) {
+        viewportWidth = (float)width;
+        viewportHeight = (float)height;
+    }
+
+    size_t addCircle(float x, float y, float radius, float r, float g, float b) {
+        return add(x, y, radius, radius, radius, 0.0f, r, g, b);
+    }
+
+    size_t addRing(float x, float y, float radius, float thickness, float r, float g, float b) {
+        return add(x, y, radius, radius, radius, thickness, r, g, b);
+    }
+
+    // thickness > 0 - только контур
+    size_t addRoundedRect(float x, float y, float width, float height, float cornerRadius,
+        float r, float g, float b, float thickness = 0.0f) {
+        return add(x, y, width * 0.5f, height * 0.5f, cornerRadius, thickness, r, g, b);
+    }
+
+    void clear() {
+        shapes.clear();
+        dirty = true;
+    }
+
+    void submit(RenderQueue::Queue& queue, uint8_t layer) {
+        if (shapes.empty()) return;
+
+        if (dirty) {
+            glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+            if (shapes.size() > capacity) {
+                capacity = std::max<size_t>(shapes.size(), capacity * 2);
+                glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(SDFShape), NULL, GL_DYNAMIC_DRAW);
+            }
+            glBufferSubData(GL_ARRAY_BUFFER, 0, shapes.size() * sizeof(SDFShape), shapes.data());
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            dirty = false;
+        }
+
+        RenderQueue::DrawCommand command;
+        command.program = program;
+        command.vertexArray = VAO;
+        command.blend = true;
+        command.mode = GL_TRIANGLE_STRIP;
+        command.count = 4;
+        command.instanceCount = (GLsizei)shapes.size();
+        command.callback = [](const RenderQueue::DrawCommand& c) {
+            const SDFShapeRenderer* renderer = (const SDFShapeRenderer*)c.userData;
+            glUniform2f(renderer->viewportLoc, renderer->viewportWidth, renderer->viewportHeight);
+        };
+        command.userData = this;
+        queue.submit(command, layer);
     }
 };
 
@@ -212,9 +962,10 @@ unsigned int compileShader(unsigned int type, const char* source) {
     return shader;
 }
 
-unsigned int createShaderProgram() {
-    unsigned int vertexShader = compileShader(GL_VERTEX_SHADER, vertexShaderSource);
-    unsigned int fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentShaderSource);
+unsigned int createShaderProgram(const char* vertexSource = vertexShaderSource,
+    const char* fragmentSource = fragmentShaderSource) {
+    unsigned int vertexShader = compileShader(GL_VERTEX_SHADER, vertexSource);
+    unsigned int fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentSource);
 
     unsigned int shaderProgram = glCreateProgram();
     glAttachShader(shaderProgram, vertexShader);
@@ -235,74 +986,305 @@ unsigned int createShaderProgram() {
     return shaderProgram;
 }
 
-int main() {
-    // Инициализация GLFW
-    if (!glfwInit()) {
-        std::cerr << "Не удалось инициализировать GLFW" << std::endl;
-        return -1;
+int main(int argc, char** argv) {
+    // --headless: без окна, рисование во внеэкранный буфер заданное число кадров
+    Headless::Options headless = Headless::parseArgs(argc, argv, 800, 600);
+    Headless::Context offscreen;
+    GLFWwindow* window = nullptr;
+
+    if (headless.enabled) {
+        if (!offscreen.create(headless)) return -1;
     }
+    else {
+        // Инициализация GLFW
+        if (!glfwInit()) {
+            std::cerr << "Не удалось инициализировать GLFW" << std::endl;
+            return -1;
+        }
 
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
-    // Создание окна
-    GLFWwindow* window = glfwCreateWindow(800, 600, "2D Фигуры OpenGL", nullptr, nullptr);
-    if (!window) {
-        std::cerr << "Не удалось создать окно GLFW" << std::endl;
-        glfwTerminate();
-        return -1;
-    }
+        // Создание окна
+        window = glfwCreateWindow(800, 600, "2D Фигуры OpenGL", nullptr, nullptr);
+        if (!window) {
+            std::cerr << "Не удалось создать окно GLFW" << std::endl;
+            glfwTerminate();
+            return -1;
+        }
 
-    glfwMakeContextCurrent(window);
+        glfwMakeContextCurrent(window);
 
-    // Инициализация GLEW
-    if (glewInit() != GLEW_OK) {
-        std::cerr << "Не удалось инициализировать GLEW" << std::endl;
-        return -1;
+        // Инициализация GLEW
+        if (glewInit() != GLEW_OK) {
+            std::cerr << "Не удалось инициализировать GLEW" << std::endl;
+            return -1;
+        }
     }
 
     // Компиляция шейдеров
     unsigned int shaderProgram = createShaderProgram();
 
-    // Создание фигур
+    // Создание фигур (рисуются через общий пакет, собственные VAO им не нужны)
     Triangle triangle(1.0f, 0.0f, 0.0f);
     Rectangle rectangle(0.0f, 1.0f, 0.0f);
-    Circle circle(50, 0.0f, 0.0f, 1.0f);
     Line line(1.0f, 1.0f, 0.0f);
 
-    triangle.create();
-    rectangle.create();
-    circle.create();
-    line.create();
+    // "Панель" из множества мелких фигур: 200 x 150 = 30000 экземпляров общей геометрии
+    const int GRID_X = 200, GRID_Y = 150;
+    const ShapeKind gridKinds[3] = { ShapeKind::Triangle, ShapeKind::Rectangle, ShapeKind::Circle };
+    const float gridColors[3][3] = { { 0.6f, 0.3f, 0.3f }, { 0.3f, 0.6f, 0.3f }, { 0.3f, 0.3f, 0.6f } };
+
+    unsigned int instancedProgram = createShaderProgram(instancedVertexShaderSource, fragmentShaderSource);
+    ShapeRegistry shapes;
+    shapes.create();
+
+    std::vector<size_t> gridIndex(GRID_X * GRID_Y);
+    float cellX = 2.0f / GRID_X, cellY = 2.0f / GRID_Y;
+    float gridShapeSize = 0.8f * std::min(cellX, cellY);
+
+    // Пространственный индекс панели: идентификатор в дереве = номер ячейки j * GRID_X + i
+    SpatialIndex::LooseQuadtree gridTree(-1.0f, -1.0f, 1.0f, 1.0f);
+    gridTree.reserve(GRID_X * GRID_Y);
+
+    for (int j = 0; j < GRID_Y; j++) {
+        for (int i = 0; i < GRID_X; i++) {
+            int type = (i + j) % 3;
+            float x = -1.0f + (i + 0.5f) * cellX, y = -1.0f + (j + 0.5f) * cellY;
+            gridIndex[j * GRID_X + i] = shapes.add(gridKinds[type], x, y, gridShapeSize, 0.0f,
+                gridColors[type][0], gridColors[type][1], gridColors[type][2]);
+            gridTree.insert(SpatialIndex::boxAround(x, y, gridShapeSize * 0.5f, gridShapeSize * 0.5f));
+        }
+    }
+    gridTree.optimize();
+
+    int viewportWidth = headless.enabled ? headless.width : 800;
+    int viewportHeight = headless.enabled ? headless.height : 600;
+
+    ShapeBatch batch;
+    batch.create();
+    batch.setViewport(viewportWidth, viewportHeight);
+
+    // Круг, кольцо и скруглённые прямоугольники - по одному квадрату на фигуру (размеры в пикселях)
+    unsigned int sdfProgram = createShaderProgram(sdfVertexShaderSource, sdfFragmentShaderSource);
+    SDFShapeRenderer sdfShapes;
+    sdfShapes.create(sdfProgram);
+    sdfShapes.setViewport(viewportWidth, viewportHeight);
+
+    float quarterX = viewportWidth * 0.25f, quarterY = viewportHeight * 0.25f;
+    float shapeSize = 0.4f * std::min(viewportWidth, viewportHeight);
+    sdfShapes.addCircle(quarterX, quarterY, shapeSize * 0.5f, 0.0f, 0.0f, 1.0f);
+    sdfShapes.addRing(quarterX, quarterY, shapeSize * 0.6f, 6.0f, 0.4f, 0.6f, 1.0f);
+    sdfShapes.addRoundedRect(3.0f * quarterX, 1.4f * quarterY, shapeSize * 1.2f, shapeSize * 0.3f,
+        shapeSize * 0.1f, 1.0f, 0.5f, 0.0f);
+    sdfShapes.addRoundedRect(3.0f * quarterX, 0.6f * quarterY, shapeSize * 1.2f, shapeSize * 0.3f,
+        shapeSize * 0.15f, 1.0f, 0.5f, 0.0f, 3.0f);
+
+    // Подсвеченная строка панели: белая и приподнята на треть ячейки
+    int highlightedRow = -1;
+    const float rowLift = 0.3f * cellY;
+
+    auto setCellColor = [&](uint32_t cell, float r, float g, float b) {
+        int i = cell % GRID_X, j = cell / GRID_X;
+        shapes.setColor(gridKinds[(i + j) % 3], gridIndex[cell], r, g, b);
+    };
+    auto restoreCellColor = [&](uint32_t cell) {
+        int i = cell % GRID_X, j = cell / GRID_X;
+        const float* color = gridColors[(i + j) % 3];
+        if (j == highlightedRow) setCellColor(cell, 1.0f, 1.0f, 1.0f);
+        else setCellColor(cell, color[0], color[1], color[2]);
+    };
+
+    // Фигуры под "кистью" вокруг курсора и под самим курсором - из запросов к индексу
+    std::vector<uint32_t> touchedCells, cursorHits, movedCells;
+    std::vector<SpatialIndex::Box> movedBoxes;
+
+    // Искры живут 20-80 кадров: постоянное создание и удаление фигур, но вершины -
+    // диапазоны общего буфера, а не отдельные glGenBuffers/glDeleteBuffers
+    ShapeGeometryPool geometryPool;
+    geometryPool.create(64 * 1024);
+    std::vector<std::unique_ptr<Spark>> sparks;
+    uint32_t sparkSeed = 12345;
+    auto sparkRandom = [&sparkSeed]() {
+        sparkSeed = sparkSeed * 1664525u + 1013904223u;
+        return (sparkSeed >> 8) / 16777216.0f;
+    };
+    int frame = 0;
+
+    // "Остров" из слоя карты: изрезанный берег на 20000 вершин и два озера-дыры
+    Triangulation::Cache triangulations;
+    Triangulation::Rings islandRings(3);
+    const int COAST_POINTS = 20000, LAKE_POINTS = 500;
+    for (int i = 0; i < COAST_POINTS; i++) {
+        float theta = 2.0f * 3.14159265f * i / COAST_POINTS;
+        float radius = 0.2f * (1.0f + 0.15f * sinf(7.0f * theta) + 0.05f * sinf(53.0f * theta) +
+            0.02f * sinf(911.0f * theta));
+        islandRings[0].insert(islandRings[0].end(), { radius * cosf(theta), radius * sinf(theta) * 1.3f });
+    }
+    for (int lake = 0; lake < 2; lake++) {
+        float centerX = lake == 0 ? -0.07f : 0.06f, centerY = lake == 0 ? 0.03f : -0.05f;
+        for (int i = 0; i < LAKE_POINTS; i++) {
+            float theta = 2.0f * 3.14159265f * i / LAKE_POINTS;
+            float radius = 0.035f * (1.0f + 0.2f * sinf(5.0f * theta));
+            islandRings[1 + lake].insert(islandRings[1 + lake].end(),
+                { centerX + radius * cosf(theta), centerY + radius * sinf(theta) * 1.3f });
+        }
+    }
+
+    // Слой загружается дважды, как при перезагрузке карты: второй раз триангуляция берётся из кэша
+    auto loadStart = std::chrono::steady_clock::now();
+    Polygon island(triangulations, islandRings, 0.3f, 0.6f, 0.3f);
+    auto loadMiddle = std::chrono::steady_clock::now();
+    island = Polygon(triangulations, islandRings, 0.3f, 0.6f, 0.3f);
+    auto loadEnd = std::chrono::steady_clock::now();
+    island.create(geometryPool);
+    std::cout << "Остров: " << COAST_POINTS + 2 * LAKE_POINTS << " вершин, триангуляция "
+        << std::chrono::duration<double, std::milli>(loadMiddle - loadStart).count() << " мс, повторно из кэша "
+        << std::chrono::duration<double, std::milli>(loadEnd - loadMiddle).count() << " мс" << std::endl;
+
+    // Кадр собирается в очередь: порядок наложения задаёт слой, внутри слоя команды
+    // группируются по программе и VAO (сотни искр - одна привязка VAO)
+    RenderQueue::Queue renderQueue;
+    const uint8_t LAYER_BACKGROUND = 0, LAYER_SPARKS = 1, LAYER_SHAPES = 2, LAYER_SDF = 3;
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    // Время кадра по областям (--profile имя - выгрузка в имя.csv и имя.json)
+    const char* profileOutput = Profiler::parseArgs(argc, argv);
+    Profiler::FrameProfiler profiler;
 
     // Основной цикл рендеринга
-    while (!glfwWindowShouldClose(window)) {
+    while (headless.enabled ? offscreen.nextFrame() : !glfwWindowShouldClose(window)) {
+        profiler.beginFrame();
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT);
 
-        glUseProgram(shaderProgram);
+        // Курсор: мышь в окне, в безоконном режиме - фигура Лиссажу
+        float cursorX, cursorY;
+        if (headless.enabled) {
+            cursorX = 0.8f * sinf(frame * 0.015f);
+            cursorY = 0.7f * sinf(frame * 0.022f);
+        }
+        else {
+            double mouseX, mouseY;
+            int windowWidth, windowHeight;
+            glfwGetCursorPos(window, &mouseX, &mouseY);
+            glfwGetWindowSize(window, &windowWidth, &windowHeight);
+            cursorX = (float)(mouseX / windowWidth * 2.0 - 1.0);
+            cursorY = (float)(1.0 - mouseY / windowHeight * 2.0);
+        }
+
+        profiler.beginCpu("индекс");
+
+        // Вернуть цвет фигурам, выделенным в прошлом кадре
+        for (uint32_t cell : touchedCells) restoreCellColor(cell);
+        touchedCells.clear();
+
+        // Бегущая подсветка: прежняя строка опускается на место, новая поднимается;
+        // индекс получает сдвинутые прямоугольники одной пачкой
+        int row = (highlightedRow + 1) % GRID_Y;
+        movedCells.clear();
+        movedBoxes.clear();
+        for (int i = 0; i < GRID_X; i++) {
+            for (int j : { highlightedRow, row }) {
+                if (j < 0) continue;
+                uint32_t cell = j * GRID_X + i;
+                int type = (i + j) % 3;
+                float y = -1.0f + (j + 0.5f) * cellY + (j == row ? rowLift : 0.0f);
+                ShapeInstance& instance = shapes.edit(gridKinds[type], gridIndex[cell]);
+                instance.y = y;
+                if (j == row) setCellColor(cell, 1.0f, 1.0f, 1.0f);
+                else setCellColor(cell, gridColors[type][0], gridColors[type][1], gridColors[type][2]);
+                movedCells.push_back(cell);
+                movedBoxes.push_back(SpatialIndex::boxAround(instance.x, y, gridShapeSize * 0.5f, gridShapeSize * 0.5f));
+            }
+        }
+        gridTree.updateBatch(movedCells.data(), movedBoxes.data(), movedCells.size());
+        highlightedRow = row;
+
+        // Кисть - запрос прямоугольника, фигура под курсором - точки (или ближайшая в пределах ячейки)
+        gridTree.queryRect(SpatialIndex::boxAround(cursorX, cursorY, 0.08f, 0.08f), touchedCells);
+        for (uint32_t cell : touchedCells) setCellColor(cell, 0.2f, 0.8f, 0.9f);
 
-        // Рисование фигур в разных позициях
-        // Можно добавить матрицы трансформации для перемещения
+        cursorHits.clear();
+        gridTree.queryPoint(cursorX, cursorY, cursorHits);
+        uint32_t picked = cursorHits.empty() ? gridTree.nearest(cursorX, cursorY, cellX) : cursorHits[0];
+        if (picked != SpatialIndex::INVALID_ID) {
+            setCellColor(picked, 1.0f, 1.0f, 0.0f);
+            touchedCells.push_back(picked);
+        }
 
-        // Треугольник
-        triangle.render();
+        profiler.endCpu();
 
-        // Прямоугольник
-        rectangle.render();
+        // Фон из мелких фигур - по одной команде на тип
+        shapes.submit(renderQueue, instancedProgram, LAYER_BACKGROUND);
+
+        // Искры: истёкшие оставляют дыры в буфере, новые занимают первые подходящие
+        profiler.beginCpu("искры");
+        sparks.erase(std::remove_if(sparks.begin(), sparks.end(),
+            [frame](const std::unique_ptr<Spark>& spark) { return spark->getExpiry() <= frame; }),
+            sparks.end());
+        for (int k = 0; k < 8; k++) {
+            float brightness = 0.7f + 0.3f * sparkRandom();
+            sparks.push_back(std::make_unique<Spark>(
+                sparkRandom() * 2.0f - 1.0f, sparkRandom() * 2.0f - 1.0f,
+                0.005f + 0.02f * sparkRandom(), 3 + (int)(sparkRandom() * 10.0f),
+                brightness, brightness, 0.5f * brightness, frame + 20 + (int)(sparkRandom() * 60.0f)));
+            sparks.back()->create(geometryPool);
+        }
+        geometryPool.defragment(16 * 1024);
+        for (const std::unique_ptr<Spark>& spark : sparks) spark->submit(renderQueue, shaderProgram, LAYER_SPARKS);
+        profiler.endCpu();
+        frame++;
 
-        // Круг
-        circle.render();
+        // Крупные фигуры - по четвертям экрана
+        triangle.appendTo(batch, Transform2D::make(-0.5f, 0.5f, 0.8f));
+        rectangle.appendTo(batch, Transform2D::make(0.5f, 0.5f, 0.8f));
+        line.appendTo(batch, Transform2D::make(0.5f, -0.5f, 0.8f));
 
-        // Линия
-        line.render();
+        // Крупные фигуры - одной командой
+        batch.submit(renderQueue, shaderProgram, LAYER_SHAPES);
+        island.submit(renderQueue, shaderProgram, LAYER_SHAPES);
 
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        // Круглые и скруглённые фигуры - по SDF
+        sdfShapes.submit(renderQueue, LAYER_SDF);
+
+        // Сортировка по состоянию и отрисовка всего кадра
+        {
+            Profiler::CpuScope cpuScope(profiler, "отрисовка");
+            Profiler::GpuScope gpuScope(profiler, "отрисовка");
+            renderQueue.flush();
+        }
+
+        if (!headless.enabled) {
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+        }
+        profiler.endFrame();
     }
 
+    profiler.flush();
+    profiler.printSummary(std::cout);
+    if (profileOutput && !profiler.save(profileOutput)) {
+        std::cerr << "Не удалось сохранить профиль " << profileOutput << std::endl;
+    }
+
+    if (headless.enabled) offscreen.finish();
+
+    const GeometryPool::VertexMegabuffer& vertexPool = geometryPool.getBuffer();
+    std::cout << "Буфер вершин: фигур " << vertexPool.getAllocationCount()
+        << ", занято " << vertexPool.getUsed() / 1024 << " из " << vertexPool.getCapacity() / 1024
+        << " КБ, свободных блоков " << vertexPool.getFreeBlockCount()
+        << ", перемещено при дефрагментации " << vertexPool.getMovedBytes() / 1024 << " КБ" << std::endl;
+
+    const RenderQueue::StateCache::Stats& queueStats = renderQueue.getStats();
+    std::cout << "Очередь отрисовки (последний кадр): команд " << renderQueue.getCommandCount()
+        << ", смен программы " << queueStats.programChanges << ", VAO " << queueStats.vertexArrayChanges
+        << ", смешивания " << queueStats.blendChanges << ", пропущено привязок " << queueStats.skipped << std::endl;
+
     glDeleteProgram(shaderProgram);
-    glfwTerminate();
+    glDeleteProgram(instancedProgram);
+    glDeleteProgram(sdfProgram);
+    if (!headless.enabled) glfwTerminate();
     return 0;
 }
\ No newline at end of file